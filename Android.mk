@@ -35,6 +35,10 @@ LOCAL_CFLAGS := -DUSE_SDL2_LOAD -I$(LOCAL_PATH)/TmxParser -I$(LOCAL_PATH)/TmxPar
 
 LOCAL_SRC_FILES := $(foreach F, $(APP_SUBDIRS), $(addprefix $(F)/,$(notdir $(wildcard $(LOCAL_PATH)/$(F)/*.cpp))))
 
+# The bundled zstd decoder, without its x86-64 assembly
+LOCAL_SRC_FILES += $(patsubst $(LOCAL_PATH)/%, %, $(wildcard $(LOCAL_PATH)/TmxParser/zstd/*/*.c))
+LOCAL_CFLAGS += -DZSTD_DISABLE_ASM
+
 LOCAL_LDLIBS := -lz
 LOCAL_SHARED_LIBRARIES := SDL2
 
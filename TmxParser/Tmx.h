@@ -39,4 +39,10 @@
 #include "TmxPolyline.h"
 #include "TmxPropertySet.h"
 #include "TmxUtil.h"
-#include "TmxImageLayer.h"
\ No newline at end of file
+#include "TmxImageLayer.h"
+#include "TmxTileClassifier.h"
+#include "TmxParseOptions.h"
+#include "TmxBinaryMap.h"
+#include "TmxArena.h"
+#include "TmxProperty.h"
+#include "TmxStringPool.h"
\ No newline at end of file
@@ -0,0 +1,164 @@
+//-----------------------------------------------------------------------------
+// TmxArena.cpp
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#include <stdlib.h>
+
+#include "TmxThreads.h"
+#include "TmxArena.h"
+
+// Freed blocks are kept for other arenas where the standard library has a
+// mutex to guard them, they go back to the system otherwise. The list is
+// shared by every map of the process, so without the mutex it would race
+// between threads loading and unloading maps of their own.
+#ifdef TMX_USE_THREADS
+#include <mutex>
+#endif
+
+namespace Tmx
+{
+	// Every allocation is aligned to this, enough for any type.
+	static const size_t Alignment = 16;
+
+	// The size of the blocks, larger allocations get a block of their own.
+	static const size_t BlockSize = 64 * 1024;
+
+	// The number of freed blocks kept for other arenas. The memory of a
+	// map unloaded is then reused by the next one instead of being given
+	// back to the system and faulted in again. Up to 64 blocks of 64KB,
+	// 4MB, stay cached until the process exits.
+	static const size_t MaxFreeBlocks = 64;
+
+	// The size of a block header, its next pointer and size, keeping the
+	// memory after it aligned.
+	static const size_t BlockHeaderSize = (sizeof(void*) + sizeof(size_t) + Alignment - 1) / Alignment * Alignment;
+
+	Arena::Block *Arena::free_blocks = NULL;
+	size_t Arena::num_free_blocks = 0;
+
+#ifdef TMX_USE_THREADS
+	static std::mutex free_blocks_mutex;
+#endif
+
+	Arena::Arena()
+		: blocks(NULL)
+		, free_begin(NULL)
+		, free_end(NULL)
+		, destructors(NULL)
+		, capacity(0)
+	{}
+
+	Arena::~Arena()
+	{
+		Clear();
+	}
+
+	void *Arena::Allocate(size_t size)
+	{
+		size = (size + Alignment - 1) / Alignment * Alignment;
+
+		if (size > (size_t)(free_end - free_begin))
+		{
+			Block *block = NewBlock(size > BlockSize - BlockHeaderSize ? BlockHeaderSize + size : BlockSize);
+			block->next = blocks;
+			blocks = block;
+			capacity += block->size;
+
+			free_begin = reinterpret_cast< char* >(block) + BlockHeaderSize;
+			free_end = reinterpret_cast< char* >(block) + block->size;
+		}
+
+		void *memory = free_begin;
+		free_begin += size;
+		return memory;
+	}
+
+	void Arena::Clear()
+	{
+		// The destructors are listed from the last object made.
+		while (destructors)
+		{
+			Destructor *destructor = destructors;
+			destructors = destructor->next;
+			destructor->destroy(destructor->object);
+		}
+
+		while (blocks)
+		{
+			Block *block = blocks;
+			blocks = block->next;
+			FreeBlock(block);
+		}
+
+		free_begin = NULL;
+		free_end = NULL;
+		capacity = 0;
+	}
+
+	Arena::Block *Arena::NewBlock(size_t size)
+	{
+#ifdef TMX_USE_THREADS
+		if (size == BlockSize)
+		{
+			std::lock_guard< std::mutex > lock(free_blocks_mutex);
+			if (free_blocks)
+			{
+				Block *block = free_blocks;
+				free_blocks = block->next;
+				--num_free_blocks;
+				return block;
+			}
+		}
+#endif
+
+		Block *block = static_cast< Block* >(malloc(size));
+		if (!block)
+		{
+			throw std::bad_alloc();
+		}
+		block->size = size;
+		return block;
+	}
+
+	void Arena::FreeBlock(Block *block)
+	{
+#ifdef TMX_USE_THREADS
+		if (block->size == BlockSize)
+		{
+			std::lock_guard< std::mutex > lock(free_blocks_mutex);
+			if (num_free_blocks < MaxFreeBlocks)
+			{
+				block->next = free_blocks;
+				free_blocks = block;
+				++num_free_blocks;
+				return;
+			}
+		}
+#endif
+
+		free(block);
+	}
+};
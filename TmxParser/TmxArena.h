@@ -0,0 +1,132 @@
+//-----------------------------------------------------------------------------
+// TmxArena.h
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <stddef.h>
+#include <new>
+
+namespace Tmx
+{
+	//-------------------------------------------------------------------------
+	// Hands out memory from large blocks and frees it all at once.
+	// A map builds its elements, tiles and objects in an arena of its own,
+	// they are destroyed together with it instead of being deleted one by
+	// one. The objects made by New() are destroyed in the reverse order of
+	// their making, objects cannot be freed on their own.
+	//-------------------------------------------------------------------------
+	class Arena
+	{
+	private:
+		// Prevent copy constructor.
+		Arena(const Arena &_arena);
+		Arena &operator=(const Arena &_arena);
+
+	public:
+		Arena();
+		~Arena();
+
+		// Get size bytes of memory, aligned for any type.
+		void *Allocate(size_t size);
+
+		// Make an object in the arena, it is destroyed by Clear().
+		template< typename T >
+		T *New()
+		{
+			T *object = new (Allocate(sizeof(T))) T();
+			AddDestructor(object);
+			return object;
+		}
+
+		template< typename T, typename A >
+		T *New(const A &a)
+		{
+			T *object = new (Allocate(sizeof(T))) T(a);
+			AddDestructor(object);
+			return object;
+		}
+
+		template< typename T, typename A, typename B, typename C, typename D >
+		T *New(const A &a, const B &b, const C &c, const D &d)
+		{
+			T *object = new (Allocate(sizeof(T))) T(a, b, c, d);
+			AddDestructor(object);
+			return object;
+		}
+
+		// Destroy the objects of the arena and free all of its memory.
+		void Clear();
+
+		// Get the number of bytes allocated from the system.
+		size_t GetCapacity() const { return capacity; }
+
+	private:
+		struct Block
+		{
+			Block *next;
+			size_t size;
+		};
+
+		struct Destructor
+		{
+			Destructor *next;
+			void *object;
+			void (*destroy)(void *object);
+		};
+
+		template< typename T >
+		static void Destroy(void *object)
+		{
+			static_cast< T* >(object)->~T();
+		}
+
+		template< typename T >
+		void AddDestructor(T *object)
+		{
+			Destructor *destructor = static_cast< Destructor* >(Allocate(sizeof(Destructor)));
+			destructor->next = destructors;
+			destructor->object = object;
+			destructor->destroy = &Destroy< T >;
+			destructors = destructor;
+		}
+
+		// Get a block of size bytes, or give it back.
+		static Block *NewBlock(size_t size);
+		static void FreeBlock(Block *block);
+
+		// The freed blocks kept for other arenas, shared by the whole process
+		// and only used when the library has a mutex to guard them.
+		static Block *free_blocks;
+		static size_t num_free_blocks;
+
+		Block *blocks;
+		char *free_begin;
+		char *free_end;
+		Destructor *destructors;
+		size_t capacity;
+	};
+};
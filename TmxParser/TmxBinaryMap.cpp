@@ -0,0 +1,766 @@
+//-----------------------------------------------------------------------------
+// TmxBinaryMap.cpp
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+
+#include "TmxBinaryMap.h"
+#include "TmxArena.h"
+#include "TmxStringPool.h"
+#include "TmxMap.h"
+#include "TmxLayer.h"
+#include "TmxTileset.h"
+#include "TmxTile.h"
+#include "TmxImage.h"
+#include "TmxImageLayer.h"
+#include "TmxObjectGroup.h"
+#include "TmxObject.h"
+#include "TmxEllipse.h"
+#include "TmxPolygon.h"
+#include "TmxPolyline.h"
+#include "TmxPropertySet.h"
+#include "TmxParseOptions.h"
+
+using std::string;
+
+namespace Tmx
+{
+	// The header of the file, in words.
+	enum BinaryHeader
+	{
+		TMXB_MAGIC,
+		TMXB_VERSION,
+		TMXB_BYTE_ORDER,
+		TMXB_STRING_COUNT,
+		TMXB_CONTENT_OFFSET,
+		TMXB_CONTENT_SIZE,
+		TMXB_HEADER_SIZE = 8
+	};
+
+	static const char BinaryMagic[4] = { 'T', 'M', 'X', 'B' };
+	static const unsigned BinaryByteOrder = 0x01020304;
+
+	// The shapes an object may have.
+	static const unsigned ObjectEllipse = 0x01;
+	static const unsigned ObjectPolygon = 0x02;
+	static const unsigned ObjectPolyline = 0x04;
+
+	BinaryMap::BinaryMap()
+		: words()
+		, strings()
+		, string_indexes()
+		, map(NULL)
+		, data(NULL)
+		, size(0)
+		, string_offsets(NULL)
+		, string_count(0)
+		, pos(NULL)
+		, end(NULL)
+		, gids_in_place(false)
+	{}
+
+	unsigned char BinaryMap::Write(const Map &map, const string &fileName)
+	{
+		BinaryMap writer;
+
+		// The content, the strings are gathered along the way.
+		unsigned version[2];
+		memcpy(version, &map.version, sizeof(version));
+		writer.Put(version[0]);
+		writer.Put(version[1]);
+		writer.Put(map.orientation);
+		writer.Put(map.width);
+		writer.Put(map.height);
+		writer.Put(map.tile_width);
+		writer.Put(map.tile_height);
+		writer.PutProperties(map.properties);
+
+		writer.Put(map.tilesets.size());
+		for (unsigned int i = 0; i < map.tilesets.size(); ++i)
+		{
+			writer.PutTileset(*map.tilesets[i]);
+		}
+		writer.Put(map.layers.size());
+		for (unsigned int i = 0; i < map.layers.size(); ++i)
+		{
+			writer.PutLayer(*map.layers[i]);
+		}
+		writer.Put(map.image_layers.size());
+		for (unsigned int i = 0; i < map.image_layers.size(); ++i)
+		{
+			writer.PutImageLayer(*map.image_layers[i]);
+		}
+		writer.Put(map.object_groups.size());
+		for (unsigned int i = 0; i < map.object_groups.size(); ++i)
+		{
+			writer.PutObjectGroup(*map.object_groups[i]);
+		}
+
+		// Lay out the strings after the header and their offsets.
+		const unsigned stringCount = writer.strings.size();
+		std::vector< unsigned > offsets(stringCount);
+		unsigned offset = (TMXB_HEADER_SIZE + stringCount) * 4;
+		for (unsigned i = 0; i < stringCount; ++i)
+		{
+			offsets[i] = offset;
+			offset += 4 + (writer.strings[i]->size() + 3) / 4 * 4;
+		}
+
+		unsigned header[TMXB_HEADER_SIZE] = { 0 };
+		memcpy(&header[TMXB_MAGIC], BinaryMagic, 4);
+		header[TMXB_VERSION] = Version;
+		header[TMXB_BYTE_ORDER] = BinaryByteOrder;
+		header[TMXB_STRING_COUNT] = stringCount;
+		header[TMXB_CONTENT_OFFSET] = offset / 4;
+		header[TMXB_CONTENT_SIZE] = writer.words.size();
+
+		FILE *file = fopen(fileName.c_str(), "wb");
+		if (!file)
+		{
+			return TMX_COULDNT_OPEN;
+		}
+
+		bool written = fwrite(header, sizeof(header), 1, file) == 1;
+		if (stringCount > 0)
+		{
+			written = written && fwrite(&offsets[0], 4, stringCount, file) == stringCount;
+		}
+		for (unsigned i = 0; i < stringCount && written; ++i)
+		{
+			const string &text = *writer.strings[i];
+			const unsigned length = text.size();
+			const char padding[4] = { 0 };
+			written = fwrite(&length, 4, 1, file) == 1
+				&& fwrite(text.data(), 1, length, file) == length
+				&& fwrite(padding, 1, (4 - length % 4) % 4, file) == (4 - length % 4) % 4;
+		}
+		if (!writer.words.empty())
+		{
+			written = written && fwrite(&writer.words[0], 4, writer.words.size(), file) == writer.words.size();
+		}
+
+		if (fclose(file) != 0 || !written)
+		{
+			return TMX_COULDNT_OPEN;
+		}
+		return 0;
+	}
+
+	bool BinaryMap::IsBinaryMap(const char *data, size_t size)
+	{
+		return size >= 4 && memcmp(data, BinaryMagic, 4) == 0;
+	}
+
+	bool BinaryMap::Read(Map &map, const char *data, size_t size, const ParseOptions &options, bool gidsInPlace)
+	{
+		BinaryMap reader;
+		reader.map = &map;
+		reader.data = data;
+		reader.size = size;
+		reader.gids_in_place = gidsInPlace;
+
+		const char *error = NULL;
+		const unsigned *header = (const unsigned *)data;
+		if (size < TMXB_HEADER_SIZE * 4 || (size_t)data % 4 != 0 || !IsBinaryMap(data, size))
+		{
+			error = "The binary map is invalid.";
+		}
+		else if (header[TMXB_BYTE_ORDER] != BinaryByteOrder)
+		{
+			error = "The binary map was written with another byte order.";
+		}
+		else if (header[TMXB_VERSION] != Version)
+		{
+			error = "The version of the binary map is not supported.";
+		}
+		else if (header[TMXB_STRING_COUNT] > size / 4 - TMXB_HEADER_SIZE
+			|| header[TMXB_CONTENT_OFFSET] > size / 4
+			|| header[TMXB_CONTENT_SIZE] > size / 4 - header[TMXB_CONTENT_OFFSET])
+		{
+			error = "The binary map is truncated.";
+		}
+
+		if (!error)
+		{
+			reader.string_offsets = header + TMXB_HEADER_SIZE;
+			reader.string_count = header[TMXB_STRING_COUNT];
+			reader.pos = header + header[TMXB_CONTENT_OFFSET];
+			reader.end = reader.pos + header[TMXB_CONTENT_SIZE];
+
+			unsigned version[2] = { 0, 0 };
+			int orientation = 0;
+			bool valid = reader.Get(version[0]) && reader.Get(version[1])
+				&& reader.Get(orientation)
+				&& reader.Get(map.width) && reader.Get(map.height)
+				&& reader.Get(map.tile_width) && reader.Get(map.tile_height)
+				&& reader.GetProperties(map.properties);
+			memcpy(&map.version, version, sizeof(version));
+			map.orientation = (MapOrientation)orientation;
+
+			unsigned count = 0;
+			valid = valid && reader.Get(count);
+			for (unsigned i = 0; i < count && valid; ++i)
+			{
+				Tileset *tileset = map.arena.New< Tileset >(&map.arena);
+				valid = reader.GetTileset(*tileset, options);
+				map.AddTileset(tileset);
+			}
+
+			// The elements left out by the options are read into temporaries.
+			valid = valid && reader.Get(count);
+			for (unsigned i = 0; i < count && valid; ++i)
+			{
+				if (reader.IsParsed(options, TMX_PARSE_LAYERS))
+				{
+					Layer *layer = map.arena.New< Layer >(&map);
+					valid = reader.GetLayer(*layer, true);
+					map.AddLayer(layer);
+				}
+				else
+				{
+					Layer layer(&map);
+					valid = reader.GetLayer(layer, false);
+				}
+			}
+			valid = valid && reader.Get(count);
+			for (unsigned i = 0; i < count && valid; ++i)
+			{
+				if (reader.IsParsed(options, TMX_PARSE_IMAGE_LAYERS))
+				{
+					ImageLayer *imageLayer = map.arena.New< ImageLayer >(&map);
+					valid = reader.GetImageLayer(*imageLayer);
+					map.AddImageLayer(imageLayer);
+				}
+				else
+				{
+					ImageLayer imageLayer(&map);
+					valid = reader.GetImageLayer(imageLayer);
+				}
+			}
+			valid = valid && reader.Get(count);
+			for (unsigned i = 0; i < count && valid; ++i)
+			{
+				if (reader.IsParsed(options, TMX_PARSE_OBJECT_GROUPS))
+				{
+					ObjectGroup *objectGroup = map.arena.New< ObjectGroup >(&map.arena);
+					valid = reader.GetObjectGroup(*objectGroup);
+					map.AddObjectGroup(objectGroup);
+				}
+				else
+				{
+					ObjectGroup objectGroup;
+					valid = reader.GetObjectGroup(objectGroup);
+				}
+			}
+
+			if (!valid)
+			{
+				error = "The binary map is truncated.";
+			}
+		}
+
+		if (error)
+		{
+			map.has_error = true;
+			map.error_code = TMX_PARSING_ERROR;
+			map.error_text = error;
+			return false;
+		}
+		return true;
+	}
+
+	void BinaryMap::Put(unsigned word)
+	{
+		words.push_back(word);
+	}
+
+	void BinaryMap::PutFloat(float value)
+	{
+		unsigned word;
+		memcpy(&word, &value, 4);
+		Put(word);
+	}
+
+	void BinaryMap::PutString(const string &text)
+	{
+		// Every string is stored once.
+		std::map< string, unsigned >::iterator iter = string_indexes.find(text);
+		if (iter == string_indexes.end())
+		{
+			iter = string_indexes.insert(std::make_pair(text, (unsigned)strings.size())).first;
+			strings.push_back(&iter->first);
+		}
+		Put(iter->second);
+	}
+
+	void BinaryMap::PutProperties(const PropertySet &properties)
+	{
+		Put(properties.properties.size());
+		for (unsigned int i = 0; i < properties.properties.size(); ++i)
+		{
+			const Property &property = properties.properties[i];
+			PutString(property.GetName());
+			PutString(property.GetValue());
+			Put(property.GetType());
+		}
+	}
+
+	void BinaryMap::PutImage(const Image *image)
+	{
+		Put(image != NULL);
+		if (image)
+		{
+			PutString(image->source);
+			Put(image->width);
+			Put(image->height);
+			PutString(image->transparent_color);
+		}
+	}
+
+	void BinaryMap::PutTileset(const Tileset &tileset)
+	{
+		Put(tileset.first_gid);
+		PutString(tileset.name);
+		Put(tileset.tile_width);
+		Put(tileset.tile_height);
+		Put(tileset.margin);
+		Put(tileset.spacing);
+		Put(tileset.tile_count);
+		PutImage(tileset.image);
+		PutProperties(tileset.properties);
+
+		Put(tileset.tiles.size());
+		for (unsigned int i = 0; i < tileset.tiles.size(); ++i)
+		{
+			Put(tileset.tiles[i]->id);
+			PutProperties(tileset.tiles[i]->properties);
+		}
+	}
+
+	void BinaryMap::PutLayer(const Layer &layer)
+	{
+		PutString(layer.name);
+		Put(layer.id);
+		Put(layer.width);
+		Put(layer.height);
+		PutFloat(layer.opacity);
+		Put(layer.visible);
+		Put(layer.zOrder);
+		Put(layer.encoding);
+		Put(layer.compression);
+		PutProperties(layer.properties);
+
+		// The gids, row by row.
+		const size_t first = words.size();
+		const size_t count = (size_t)layer.width * layer.height;
+		words.resize(first + count);
+		if (count > 0)
+		{
+			layer.CopyGids(0, 0, layer.width, layer.height, &words[first]);
+		}
+	}
+
+	void BinaryMap::PutImageLayer(const ImageLayer &imageLayer)
+	{
+		PutString(imageLayer.name);
+		Put(imageLayer.id);
+		Put(imageLayer.width);
+		Put(imageLayer.height);
+		PutFloat(imageLayer.opacity);
+		Put(imageLayer.visible);
+		Put(imageLayer.zOrder);
+		PutImage(imageLayer.image);
+		PutProperties(imageLayer.properties);
+	}
+
+	void BinaryMap::PutObjectGroup(const ObjectGroup &objectGroup)
+	{
+		PutString(objectGroup.name);
+		Put(objectGroup.id);
+		Put(objectGroup.width);
+		Put(objectGroup.height);
+		Put(objectGroup.visible);
+		Put(objectGroup.zOrder);
+		PutProperties(objectGroup.properties);
+
+		Put(objectGroup.objects.size());
+		for (unsigned int i = 0; i < objectGroup.objects.size(); ++i)
+		{
+			PutObject(*objectGroup.objects[i]);
+		}
+	}
+
+	void BinaryMap::PutObject(const Object &object)
+	{
+		PutString(*object.name);
+		PutString(*object.type);
+		Put(object.id);
+		Put(object.x);
+		Put(object.y);
+		Put(object.width);
+		Put(object.height);
+		Put(object.gid);
+
+		unsigned shapes = 0;
+		if (object.ellipse) shapes |= ObjectEllipse;
+		if (object.polygon) shapes |= ObjectPolygon;
+		if (object.polyline) shapes |= ObjectPolyline;
+		Put(shapes);
+		if (object.polygon)
+		{
+			Put(object.polygon->points.size());
+			for (unsigned int i = 0; i < object.polygon->points.size(); ++i)
+			{
+				Put(object.polygon->points[i].x);
+				Put(object.polygon->points[i].y);
+			}
+		}
+		if (object.polyline)
+		{
+			Put(object.polyline->points.size());
+			for (unsigned int i = 0; i < object.polyline->points.size(); ++i)
+			{
+				Put(object.polyline->points[i].x);
+				Put(object.polyline->points[i].y);
+			}
+		}
+
+		PutProperties(object.properties);
+	}
+
+	bool BinaryMap::IsParsed(const ParseOptions &options, ParseElementType type)
+	{
+		// Every element starts with its name.
+		const unsigned *start = pos;
+		string name;
+		const bool parsed = !GetString(name) || options.IsParsed(type, name);
+		pos = start;
+		return parsed;
+	}
+
+	bool BinaryMap::Get(unsigned &word)
+	{
+		if (pos >= end)
+		{
+			return false;
+		}
+		word = *pos++;
+		return true;
+	}
+
+	bool BinaryMap::Get(int &value)
+	{
+		unsigned word;
+		if (!Get(word))
+		{
+			return false;
+		}
+		value = (int)word;
+		return true;
+	}
+
+	bool BinaryMap::Get(bool &value)
+	{
+		unsigned word;
+		if (!Get(word))
+		{
+			return false;
+		}
+		value = word != 0;
+		return true;
+	}
+
+	bool BinaryMap::GetFloat(float &value)
+	{
+		unsigned word;
+		if (!Get(word))
+		{
+			return false;
+		}
+		memcpy(&value, &word, 4);
+		return true;
+	}
+
+	bool BinaryMap::GetString(string &text)
+	{
+		unsigned index;
+		if (!Get(index) || index >= string_count)
+		{
+			return false;
+		}
+
+		const size_t offset = string_offsets[index];
+		if (offset % 4 != 0 || offset > size - 4)
+		{
+			return false;
+		}
+		const unsigned length = *(const unsigned *)(data + offset);
+		if (length > size - offset - 4)
+		{
+			return false;
+		}
+		text.assign(data + offset + 4, length);
+		return true;
+	}
+
+	bool BinaryMap::GetInternedString(const string *&text)
+	{
+		string value;
+		if (!GetString(value))
+		{
+			return false;
+		}
+		text = map->string_pool.Intern(value);
+		return true;
+	}
+
+	bool BinaryMap::GetProperties(PropertySet &properties)
+	{
+		properties.SetStringPool(&map->string_pool);
+
+		unsigned count;
+		if (!Get(count))
+		{
+			return false;
+		}
+		for (unsigned i = 0; i < count; ++i)
+		{
+			string name;
+			string value;
+			int type;
+			if (!GetString(name) || !GetString(value) || !Get(type))
+			{
+				return false;
+			}
+			properties.Add(name, value, (PropertyType)type);
+		}
+		return true;
+	}
+
+	bool BinaryMap::GetImage(Image *&image, Arena *arena)
+	{
+		bool hasImage;
+		if (!Get(hasImage))
+		{
+			return false;
+		}
+		if (!hasImage)
+		{
+			return true;
+		}
+
+		image = arena ? arena->New< Image >() : new Image();
+		return GetString(image->source)
+			&& Get(image->width)
+			&& Get(image->height)
+			&& GetString(image->transparent_color);
+	}
+
+	bool BinaryMap::GetTileset(Tileset &tileset, const ParseOptions &options)
+	{
+		unsigned tileCount;
+		if (!Get(tileset.first_gid)
+			|| !GetString(tileset.name)
+			|| !Get(tileset.tile_width)
+			|| !Get(tileset.tile_height)
+			|| !Get(tileset.margin)
+			|| !Get(tileset.spacing)
+			|| !Get(tileset.tile_count)
+			|| !GetImage(tileset.image, tileset.arena)
+			|| !GetProperties(tileset.properties)
+			|| !Get(tileCount)
+			|| tileCount > (size_t)(end - pos) / 2)
+		{
+			return false;
+		}
+
+		const bool parseTiles = options.IsParsed(TMX_PARSE_TILE_PROPERTIES, tileset.name);
+		if (parseTiles)
+		{
+			tileset.tiles.reserve(tileCount);
+		}
+		for (unsigned i = 0; i < tileCount; ++i)
+		{
+			int id;
+			PropertySet properties;
+			if (!Get(id) || !GetProperties(properties))
+			{
+				return false;
+			}
+
+			Tile *tile = parseTiles ? tileset.AddTile(id) : NULL;
+			if (tile)
+			{
+				tile->properties.SetStringPool(&map->string_pool);
+				tile->properties.properties.swap(properties.properties);
+			}
+		}
+		return true;
+	}
+
+	bool BinaryMap::GetLayer(Layer &layer, bool keepTiles)
+	{
+		int encoding;
+		int compression;
+		if (!GetString(layer.name)
+			|| !Get(layer.id)
+			|| !Get(layer.width)
+			|| !Get(layer.height)
+			|| !GetFloat(layer.opacity)
+			|| !Get(layer.visible)
+			|| !Get(layer.zOrder)
+			|| !Get(encoding)
+			|| !Get(compression)
+			|| !GetProperties(layer.properties))
+		{
+			return false;
+		}
+		layer.encoding = (LayerEncodingType)encoding;
+		layer.compression = (LayerCompressionType)compression;
+
+		if (layer.width < 0 || layer.height < 0
+			|| (size_t)layer.width * layer.height > (size_t)(end - pos))
+		{
+			return false;
+		}
+		const size_t count = (size_t)layer.width * layer.height;
+
+		// The gids are used where they lie when the layer keeps gids,
+		// otherwise they are copied or converted to map tiles.
+		if (keepTiles)
+		{
+			if (gids_in_place && layer.storage == TMX_STORAGE_GIDS)
+			{
+				layer.gid_map = const_cast< unsigned* >(pos);
+				layer.owns_gids = false;
+			}
+			else
+			{
+				layer.AllocateTiles();
+				layer.SetTiles(0, pos, count);
+			}
+		}
+		layer.is_decoded = true;
+		pos += count;
+		return true;
+	}
+
+	bool BinaryMap::GetImageLayer(ImageLayer &imageLayer)
+	{
+		return GetString(imageLayer.name)
+			&& Get(imageLayer.id)
+			&& Get(imageLayer.width)
+			&& Get(imageLayer.height)
+			&& GetFloat(imageLayer.opacity)
+			&& Get(imageLayer.visible)
+			&& Get(imageLayer.zOrder)
+			&& GetImage(imageLayer.image, NULL)
+			&& GetProperties(imageLayer.properties);
+	}
+
+	bool BinaryMap::GetObjectGroup(ObjectGroup &objectGroup)
+	{
+		unsigned objectCount;
+		if (!GetString(objectGroup.name)
+			|| !Get(objectGroup.id)
+			|| !Get(objectGroup.width)
+			|| !Get(objectGroup.height)
+			|| !Get(objectGroup.visible)
+			|| !Get(objectGroup.zOrder)
+			|| !GetProperties(objectGroup.properties)
+			|| !Get(objectCount))
+		{
+			return false;
+		}
+
+		for (unsigned i = 0; i < objectCount; ++i)
+		{
+			Object *object = objectGroup.arena ? objectGroup.arena->New< Object >(objectGroup.arena) : new Object();
+			objectGroup.objects.push_back(object);
+			if (!GetObject(*object))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool BinaryMap::GetObject(Object &object)
+	{
+		unsigned shapes;
+		if (!GetInternedString(object.name)
+			|| !GetInternedString(object.type)
+			|| !Get(object.id)
+			|| !Get(object.x)
+			|| !Get(object.y)
+			|| !Get(object.width)
+			|| !Get(object.height)
+			|| !Get(object.gid)
+			|| !Get(shapes))
+		{
+			return false;
+		}
+
+		if (shapes & ObjectEllipse)
+		{
+			object.ellipse = object.arena
+				? object.arena->New< Ellipse >(object.x, object.y, object.width, object.height)
+				: new Ellipse(object.x, object.y, object.width, object.height);
+		}
+		for (int shape = 0; shape < 2; ++shape)
+		{
+			if (!(shapes & (shape == 0 ? ObjectPolygon : ObjectPolyline)))
+			{
+				continue;
+			}
+
+			unsigned pointCount;
+			if (!Get(pointCount) || pointCount > (size_t)(end - pos) / 2)
+			{
+				return false;
+			}
+			std::vector< Point > points(pointCount);
+			for (unsigned i = 0; i < pointCount; ++i)
+			{
+				Get(points[i].x);
+				Get(points[i].y);
+			}
+			if (shape == 0)
+			{
+				object.polygon = object.arena ? object.arena->New< Polygon >() : new Polygon();
+				object.polygon->points.swap(points);
+			}
+			else
+			{
+				object.polyline = object.arena ? object.arena->New< Polyline >() : new Polyline();
+				object.polyline->points.swap(points);
+			}
+		}
+
+		return GetProperties(object.properties);
+	}
+};
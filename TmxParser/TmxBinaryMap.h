@@ -0,0 +1,136 @@
+//-----------------------------------------------------------------------------
+// TmxBinaryMap.h
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <stddef.h>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "TmxParseOptions.h"
+
+namespace Tmx
+{
+	class Arena;
+	class Map;
+	class PropertySet;
+	class Image;
+	class Tileset;
+	class Layer;
+	class ImageLayer;
+	class ObjectGroup;
+	class Object;
+
+	//-------------------------------------------------------------------------
+	// Writes parsed maps to files in a binary format and reads them back,
+	// for loading the same maps over and over without parsing the XML and
+	// decoding the layers every time. Map::ParseFile() and ParseBuffer()
+	// read these files too, they are told from TMX files by their header.
+	//
+	// The files are made of 32-bit words in the byte order of the machine
+	// which wrote them: a header, a table of the strings, which are stored
+	// once each, and the content of the map. The gids of every layer are
+	// stored row by row, so that a map using TMX_STORAGE_GIDS and read with
+	// ParseFile() serves them right from the mapped file.
+	//-------------------------------------------------------------------------
+	class BinaryMap
+	{
+	private:
+		// Prevent copy constructor.
+		BinaryMap(const BinaryMap &_binaryMap);
+		BinaryMap &operator=(const BinaryMap &_binaryMap);
+
+	public:
+		// The version of the format, files of other versions are rejected.
+		static const unsigned Version = 5;
+
+		// Write a map to a file.
+		// Returns 0 on success or the error code (TMX_ preceded constants).
+		static unsigned char Write(const Tmx::Map &map, const std::string &fileName);
+
+		// Get whether a buffer starts as a binary map.
+		static bool IsBinaryMap(const char *data, size_t size);
+
+		// Read a binary map from a buffer of size bytes into a map which was
+		// not parsed yet, leaving out the elements excluded by the options.
+		// The gids of the layers are used where they lie if gidsInPlace is
+		// set, the buffer then has to stay valid as long as the map.
+		// Returns false and sets the error of the map if the buffer is not
+		// a valid binary map.
+		static bool Read(Tmx::Map &map, const char *data, size_t size,
+			const Tmx::ParseOptions &options, bool gidsInPlace);
+
+	private:
+		BinaryMap();
+
+		// Append words to the content.
+		void Put(unsigned word);
+		void PutFloat(float value);
+		void PutString(const std::string &text);
+		void PutProperties(const Tmx::PropertySet &properties);
+		void PutImage(const Tmx::Image *image);
+		void PutTileset(const Tmx::Tileset &tileset);
+		void PutLayer(const Tmx::Layer &layer);
+		void PutImageLayer(const Tmx::ImageLayer &imageLayer);
+		void PutObjectGroup(const Tmx::ObjectGroup &objectGroup);
+		void PutObject(const Tmx::Object &object);
+
+		// Get whether the element read next is parsed with the options.
+		bool IsParsed(const Tmx::ParseOptions &options, Tmx::ParseElementType type);
+
+		// Read words from the content, these return false past its end.
+		bool Get(unsigned &word);
+		bool Get(int &value);
+		bool Get(bool &value);
+		bool GetFloat(float &value);
+		bool GetString(std::string &text);
+		bool GetInternedString(const std::string *&text);
+		bool GetProperties(Tmx::PropertySet &properties);
+		bool GetImage(Tmx::Image *&image, Tmx::Arena *arena);
+		bool GetTileset(Tmx::Tileset &tileset, const Tmx::ParseOptions &options);
+		bool GetLayer(Tmx::Layer &layer, bool keepTiles);
+		bool GetImageLayer(Tmx::ImageLayer &imageLayer);
+		bool GetObjectGroup(Tmx::ObjectGroup &objectGroup);
+		bool GetObject(Tmx::Object &object);
+
+		// Writing.
+		std::vector< unsigned > words;
+		std::vector< const std::string* > strings;
+		std::map< std::string, unsigned > string_indexes;
+
+		// Reading.
+		Tmx::Map *map;
+		const char *data;
+		size_t size;
+		const unsigned *string_offsets;
+		unsigned string_count;
+		const unsigned *pos;
+		const unsigned *end;
+		bool gids_in_place;
+	};
+};
@@ -0,0 +1,177 @@
+//-----------------------------------------------------------------------------
+// TmxFileBuffer.cpp
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#include <stdio.h>
+
+#include "TmxFileBuffer.h"
+#include "TmxMap.h"
+
+#ifdef USE_SDL2_LOAD
+#include <SDL.h>
+#endif
+
+#ifdef TMX_USE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Tmx
+{
+	FileBuffer::FileBuffer()
+		: data(NULL)
+		, size(0)
+		, mapped_size(0)
+	{}
+
+	FileBuffer::~FileBuffer()
+	{
+		Close();
+	}
+
+#ifdef TMX_USE_MMAP
+	unsigned char FileBuffer::Open(const std::string &fileName)
+	{
+		Close();
+
+		int file = open(fileName.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			return TMX_COULDNT_OPEN;
+		}
+
+		struct stat status;
+		if (fstat(file, &status) != 0 || status.st_size <= 0)
+		{
+			close(file);
+			return TMX_INVALID_FILE_SIZE;
+		}
+
+		// Reserve whole pages for the file and one more byte, the pages past
+		// the end of the file are anonymous and read as zero so the content
+		// is null terminated even when its size is a multiple of the page size.
+		const size_t pageSize = sysconf(_SC_PAGESIZE);
+		const size_t fileSize = status.st_size;
+		const size_t mappedSize = (fileSize + 1 + pageSize - 1) / pageSize * pageSize;
+
+		void *reserved = mmap(NULL, mappedSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (reserved == MAP_FAILED)
+		{
+			close(file);
+			return TMX_COULDNT_OPEN;
+		}
+
+		void *mapped = mmap(reserved, fileSize, PROT_READ, MAP_PRIVATE | MAP_FIXED, file, 0);
+		close(file);
+		if (mapped == MAP_FAILED)
+		{
+			munmap(reserved, mappedSize);
+			return TMX_COULDNT_OPEN;
+		}
+
+		// The file is read front to back.
+		madvise(mapped, fileSize, MADV_SEQUENTIAL);
+
+		data = static_cast< const char* >(mapped);
+		size = fileSize;
+		mapped_size = mappedSize;
+		return 0;
+	}
+#else
+	unsigned char FileBuffer::Open(const std::string &fileName)
+	{
+		Close();
+
+		// Open the file for reading.
+#ifdef USE_SDL2_LOAD
+		SDL_RWops * file = SDL_RWFromFile (fileName.c_str(), "rb");
+#else
+		FILE *file = fopen(fileName.c_str(), "rb");
+#endif
+
+		// Check if the file could not be opened.
+		if (!file)
+		{
+			return TMX_COULDNT_OPEN;
+		}
+
+		// Find out the file size.
+		long fileSize;
+#ifdef USE_SDL2_LOAD
+		fileSize = file->size(file);
+#else
+		fseek(file, 0, SEEK_END);
+		fileSize = ftell(file);
+		fseek(file, 0, SEEK_SET);
+#endif
+
+		// Check if the file size is valid.
+		if (fileSize <= 0)
+		{
+#ifdef USE_SDL2_LOAD
+			file->close(file);
+#else
+			fclose(file);
+#endif
+			return TMX_INVALID_FILE_SIZE;
+		}
+
+		// Allocate memory for the file and read it into the memory.
+		char *fileText = new char[fileSize + 1];
+		fileText[fileSize] = 0;
+#ifdef USE_SDL2_LOAD
+		file->read(file, fileText, 1, fileSize);
+		file->close(file);
+#else
+		fread(fileText, 1, fileSize, file);
+		fclose(file);
+#endif
+
+		data = fileText;
+		size = fileSize;
+		return 0;
+	}
+#endif
+
+	void FileBuffer::Close()
+	{
+		if (!data)
+		{
+			return;
+		}
+
+#ifdef TMX_USE_MMAP
+		munmap(const_cast< char* >(data), mapped_size);
+#else
+		delete [] data;
+#endif
+		data = NULL;
+		size = 0;
+		mapped_size = 0;
+	}
+};
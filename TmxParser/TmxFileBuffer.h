@@ -0,0 +1,77 @@
+//-----------------------------------------------------------------------------
+// TmxFileBuffer.h
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+// Files are mapped in memory where it is supported, otherwise they are
+// read into a buffer.
+#if !defined(USE_SDL2_LOAD) && !defined(_WIN32)
+#define TMX_USE_MMAP
+#endif
+
+namespace Tmx
+{
+	//-------------------------------------------------------------------------
+	// The content of a file, mapped in memory when possible and read
+	// otherwise. The content is always followed by a null character so it
+	// can be parsed as a C string without being copied.
+	//-------------------------------------------------------------------------
+	class FileBuffer
+	{
+	private:
+		// Prevent copy constructor.
+		FileBuffer(const FileBuffer &_buffer);
+		FileBuffer &operator=(const FileBuffer &_buffer);
+
+	public:
+		FileBuffer();
+		~FileBuffer();
+
+		// Open a file and map or read its content.
+		// Returns 0 on success or the error code (TMX_ preceded constants).
+		unsigned char Open(const std::string &fileName);
+
+		// Release the content.
+		void Close();
+
+		// Get the content of the file, followed by a null character.
+		const char *GetData() const { return data; }
+
+		// Get the size of the file, in bytes.
+		size_t GetSize() const { return size; }
+
+	private:
+		const char *data;
+		size_t size;
+
+		// The size of the mapping, 0 when the content was read.
+		size_t mapped_size;
+	};
+};
@@ -38,6 +38,8 @@ namespace Tmx
 	//-------------------------------------------------------------------------
 	class Image 
 	{
+		friend class BinaryMap;
+
 	public:
 		Image();
 		~Image();
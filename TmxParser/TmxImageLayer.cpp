@@ -37,6 +37,7 @@ namespace Tmx
 {
 	ImageLayer::ImageLayer(const Tmx::Map *_map) 
 		: map(_map)
+		, id(0)
 		, name()
 		, width(0)
 		, height(0)
@@ -54,10 +55,16 @@ namespace Tmx
 	}
 
 	void ImageLayer::Parse(const TiXmlNode *imageLayerNode) 
+	{
+		Parse(imageLayerNode, NULL);
+	}
+
+	void ImageLayer::Parse(const TiXmlNode *imageLayerNode, StringPool *stringPool) 
 	{
 		const TiXmlElement *imagenLayerElem = imageLayerNode->ToElement();
 
 		// Read all the attributes into local variables.
+		imagenLayerElem->Attribute("id", &id);
 		name = imagenLayerElem->Attribute("name");
 
 		imagenLayerElem->Attribute("width", &width);
@@ -89,7 +96,7 @@ namespace Tmx
 		
 		if (propertiesNode) 
 		{
-			properties.Parse(propertiesNode);
+			properties.Parse(propertiesNode, stringPool);
 		}
 	}
 
@@ -37,6 +37,7 @@ class TiXmlNode;
 namespace Tmx 
 {
 	class Map;
+	class StringPool;
 	class Image;
 
 	//-------------------------------------------------------------------------
@@ -46,6 +47,8 @@ namespace Tmx
 	//-------------------------------------------------------------------------
 	class ImageLayer 
 	{
+		friend class BinaryMap;
+
 	public:
 		ImageLayer(const Tmx::Map *_map);
 		~ImageLayer();
@@ -53,6 +56,13 @@ namespace Tmx
 		// Parse a ImageLayer element.
 		void Parse(const TiXmlNode *imageLayerNode);
 
+		// Parse a ImageLayer element, interning the strings of the
+		// properties in a pool which outlives the layer.
+		void Parse(const TiXmlNode *imageLayerNode, Tmx::StringPool *stringPool);
+
+		// Get the unique id of the ImageLayer in the map, 0 if it has none.
+		int GetId() const { return id; }
+
 		// Returns the name of the ImageLayer.
 		const std::string &GetName() const { return name; }
 
@@ -81,6 +91,7 @@ namespace Tmx
 	private:
 		const Tmx::Map *map;
 
+		int id;
 		std::string name;
 		
 		int width;
@@ -26,19 +26,21 @@
 // Author: Tamir Atias
 //-----------------------------------------------------------------------------
 #include <tinyxml.h>
-#include <zlib.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "TmxLayer.h"
 #include "TmxUtil.h"
 #include "TmxMap.h"
 #include "TmxTileset.h"
+#include "TmxXmlReader.h"
 
 namespace Tmx 
 {
 	Layer::Layer(const Map *_map) 
 		: map(_map)
+		, id(0)
 		, name() 
 		, width(0) 
 		, height(0) 
@@ -46,11 +48,20 @@ namespace Tmx
 		, visible(true)
 		, zOrder(0)
 		, properties()
+		, storage(_map->GetLayerStorage())
+		, is_decoded(false)
+		, data_text(NULL)
+		, data_length(0)
+		, data_copy()
 		, encoding(TMX_ENCODING_XML)
 		, compression(TMX_COMPRESSION_NONE)
+		, has_error(false)
+		, error_text()
 	{
 		// Set the map to null to specify that it is not yet allocated.
 		tile_map = NULL;
+		gid_map = NULL;
+		owns_gids = true;
 	}
 
 	Layer::~Layer() 
@@ -61,6 +72,11 @@ namespace Tmx
 			delete [] tile_map;
 			tile_map = NULL;
 		}
+		if (gid_map && owns_gids)
+		{
+			delete [] gid_map;
+			gid_map = NULL;
+		}
 	}
 
 	void Layer::Parse(const TiXmlNode *layerNode) 
@@ -68,6 +84,7 @@ namespace Tmx
 		const TiXmlElement *layerElem = layerNode->ToElement();
 	
 		// Read the attributes.
+		layerElem->Attribute("id", &id);
 		name = layerElem->Attribute("name");
 
 		layerElem->Attribute("width", &width);
@@ -93,14 +110,289 @@ namespace Tmx
 		}
 
 		// Allocate memory for reading the tiles.
-		tile_map = new MapTile[width * height];
+		AllocateTiles();
+		is_decoded = true;
 
 		const TiXmlNode *dataNode = layerNode->FirstChild("data");
 		const TiXmlElement *dataElem = dataNode->ToElement();
 
-		const char *encodingStr = dataElem->Attribute("encoding");
-		const char *compressionStr = dataElem->Attribute("compression");
+		ParseDataFormat(dataElem->Attribute("encoding"), dataElem->Attribute("compression"));
+
+		// Decode.
+		switch (encoding) 
+		{
+		case TMX_ENCODING_XML:
+			ParseXML(dataNode);
+			break;
+
+		case TMX_ENCODING_BASE64:
+			{
+				const char *text = dataElem->GetText();
+				ParseBase64(text ? text : "", text ? strlen(text) : 0);
+			}
+			break;
+
+		case TMX_ENCODING_CSV:
+			{
+				const char *text = dataElem->GetText();
+				ParseCSV(text ? text : "", text ? strlen(text) : 0);
+			}
+			break;
+		}
+	}
+
+	void Layer::Parse(XmlReader &reader, bool decode, StringPool *stringPool)
+	{
+		// Read the attributes.
+		id = reader.GetIntAttribute("id", 0);
+		reader.GetAttribute("name", name);
+		width = reader.GetIntAttribute("width", 0);
+		height = reader.GetIntAttribute("height", 0);
+		opacity = (float)reader.GetDoubleAttribute("opacity", 1.0);
+		visible = reader.GetIntAttribute("visible", 1) != 0;
+
+		// Allocate memory for reading the tiles, unless they are decoded
+		// later on.
+		if (decode)
+		{
+			AllocateTiles();
+			is_decoded = true;
+		}
+
+		XmlNodeType type;
+		while ((type = reader.Read()) != XML_END_ELEMENT)
+		{
+			if (type == XML_TEXT)
+			{
+				continue;
+			}
+			if (type != XML_START_ELEMENT)
+			{
+				return;
+			}
+			if (!reader.IsElement("properties") && !reader.IsElement("data"))
+			{
+				if (!reader.Skip()) return;
+				continue;
+			}
+
+			// Read the properties.
+			if (reader.IsElement("properties"))
+			{
+				TiXmlDocument document;
+				if (!reader.ReadFragment(document)) return;
+				properties.Parse(document.FirstChild(), stringPool);
+				continue;
+			}
+
+			std::string encodingStr, compressionStr;
+			reader.GetAttribute("encoding", encodingStr);
+			reader.GetAttribute("compression", compressionStr);
+			ParseDataFormat(encodingStr.c_str(), compressionStr.c_str());
+
+			if (encoding == TMX_ENCODING_XML)
+			{
+				// The tiles are elements which are read right away.
+				if (!is_decoded)
+				{
+					AllocateTiles();
+					is_decoded = true;
+				}
+				ParseXML(reader);
+				continue;
+			}
+
+			// Gather the text of the data, which is usually a single node
+			// decoded where it lies.
+			const char *text = NULL;
+			size_t length = 0;
+			std::string joinedText;
+			while ((type = reader.Read()) != XML_END_ELEMENT)
+			{
+				if (type == XML_TEXT)
+				{
+					if (!text)
+					{
+						text = reader.GetText();
+						length = reader.GetTextLength();
+						continue;
+					}
+					if (joinedText.empty())
+					{
+						joinedText.assign(text, length);
+					}
+					joinedText.append(reader.GetText(), reader.GetTextLength());
+					text = joinedText.data();
+					length = joinedText.size();
+				}
+				else if (type != XML_START_ELEMENT || !reader.Skip())
+				{
+					return;
+				}
+			}
+
+			// Keep the text for later if the layer is decoded lazily.
+			if (!is_decoded)
+			{
+				if (text == joinedText.data())
+				{
+					data_copy.swap(joinedText);
+					text = data_copy.data();
+				}
+				data_text = text ? text : "";
+				data_length = length;
+				continue;
+			}
+
+			// Decode.
+			if (encoding == TMX_ENCODING_BASE64)
+			{
+				ParseBase64(text ? text : "", length);
+			}
+			else
+			{
+				ParseCSV(text ? text : "", length);
+			}
+		}
+	}
+
+	void Layer::SetTiles(size_t first, const unsigned *gids, size_t count)
+	{
+		if (gid_map)
+		{
+			memcpy(gid_map + first, gids, count * sizeof(unsigned));
+			return;
+		}
+
+		const std::vector< Tileset* > &tilesets = map->GetTilesets();
+		int tilesetIndexes[1024];
+		while (count > 0)
+		{
+			const size_t blockCount = count < 1024 ? count : 1024;
+
+			// Find the tileset indexes of the whole block at once.
+			map->FindTilesetIndexes(gids, blockCount, tilesetIndexes);
+			for (size_t i = 0; i < blockCount; ++i)
+			{
+				const int tilesetIndex = tilesetIndexes[i];
+				if (tilesetIndex != -1)
+				{
+					// If valid, set up the map tile with the tileset.
+					tile_map[first + i] = MapTile(gids[i], tilesets[tilesetIndex]->GetFirstGid(), tilesetIndex);
+				}
+				else
+				{
+					// Otherwise, make it null.
+					tile_map[first + i] = MapTile(gids[i], 0, -1);
+				}
+			}
+
+			first += blockCount;
+			gids += blockCount;
+			count -= blockCount;
+		}
+	}
 
+	MapTile Layer::MakeTile(unsigned gid) const
+	{
+		const int tilesetIndex = map->FindTilesetIndex(gid);
+		if (tilesetIndex == -1)
+		{
+			return MapTile(gid, 0, -1);
+		}
+		return MapTile(gid, map->GetTilesets()[tilesetIndex]->GetFirstGid(), tilesetIndex);
+	}
+
+	unsigned Layer::MakeGid(const MapTile &tile) const
+	{
+		unsigned gid = tile.id;
+		if (tile.tilesetId >= 0 && tile.tilesetId < map->GetNumTilesets())
+		{
+			gid += map->GetTilesets()[tile.tilesetId]->GetFirstGid();
+		}
+		if (tile.flippedHorizontally) gid |= FlippedHorizontallyFlag;
+		if (tile.flippedVertically) gid |= FlippedVerticallyFlag;
+		if (tile.flippedDiagonally) gid |= FlippedDiagonallyFlag;
+		return gid;
+	}
+
+	void Layer::CopyGids(int x, int y, int w, int h, unsigned *out) const
+	{
+		Decode();
+		for (int row = y; row < y + h; ++row, out += w)
+		{
+			// Clip the row to the layer, [begin, end) is inside of it.
+			const int begin = x < 0 ? -x : 0;
+			const int end = x + w > width ? width - x : w;
+			if (row < 0 || row >= height || begin >= end)
+			{
+				memset(out, 0, w * sizeof(unsigned));
+				continue;
+			}
+			memset(out, 0, begin * sizeof(unsigned));
+			memset(out + end, 0, (w - end) * sizeof(unsigned));
+
+			const size_t first = (size_t)row * width + x;
+			if (gid_map)
+			{
+				memcpy(out + begin, gid_map + first + begin, (end - begin) * sizeof(unsigned));
+			}
+			else
+			{
+				for (int i = begin; i < end; ++i)
+				{
+					out[i] = MakeGid(tile_map[first + i]);
+				}
+			}
+		}
+	}
+
+	void Layer::DecodeData()
+	{
+#ifdef TMX_USE_THREADS
+		std::lock_guard< std::mutex > lock(decode_mutex);
+		if (is_decoded)
+		{
+			return;
+		}
+#endif
+		AllocateTiles();
+
+		// A layer without data keeps its empty tiles.
+		if (data_text)
+		{
+			if (encoding == TMX_ENCODING_BASE64)
+			{
+				ParseBase64(data_text, data_length);
+			}
+			else
+			{
+				ParseCSV(data_text, data_length);
+			}
+		}
+
+		data_text = NULL;
+		data_length = 0;
+		std::string().swap(data_copy);
+
+		// The tiles are only read by the other threads once this is set.
+		is_decoded = true;
+	}
+
+	void Layer::AllocateTiles()
+	{
+		if (storage == TMX_STORAGE_GIDS)
+		{
+			gid_map = new unsigned[width * height]();
+		}
+		else
+		{
+			tile_map = new MapTile[width * height];
+		}
+	}
+
+	void Layer::ParseDataFormat(const char *encodingStr, const char *compressionStr)
+	{
 		// Check for encoding.
 		if (encodingStr) 
 		{
@@ -125,23 +417,12 @@ namespace Tmx
 			{
 				compression = TMX_COMPRESSION_ZLIB;
 			}
+			else if (!strcmp(compressionStr, "zstd"))
+			{
+				compression = TMX_COMPRESSION_ZSTD;
+			}
 		}
 		
-		// Decode.
-		switch (encoding) 
-		{
-		case TMX_ENCODING_XML:
-			ParseXML(dataNode);
-			break;
-
-		case TMX_ENCODING_BASE64:
-			ParseBase64(dataElem->GetText());
-			break;
-
-		case TMX_ENCODING_CSV:
-			ParseCSV(dataElem->GetText());
-			break;
-		}
 	}
 
 	void Layer::ParseXML(const TiXmlNode *dataNode) 
@@ -161,118 +442,154 @@ namespace Tmx
 			// Convert to an unsigned.
 			sscanf(gidText, "%u", &gid);
 
-			// Find the tileset index.
-			const int tilesetIndex = map->FindTilesetIndex(gid);
-			if (tilesetIndex != -1)
+			SetTiles(tileCount, &gid, 1);
+
+			tileNode = dataNode->IterateChildren("tile", tileNode);
+			tileCount++;
+		}
+	}
+
+	void Layer::ParseXML(XmlReader &reader)
+	{
+		int tileCount = 0;
+
+		XmlNodeType type;
+		while ((type = reader.Read()) != XML_END_ELEMENT)
+		{
+			if (type != XML_START_ELEMENT)
 			{
-				// If valid, set up the map tile with the tileset.
-				const Tmx::Tileset* tileset = map->GetTileset(tilesetIndex);
-				tile_map[tileCount] = MapTile(gid, tileset->GetFirstGid(), tilesetIndex);
+				if (type == XML_TEXT) continue;
+				return;
 			}
-			else
+
+			if (reader.IsElement("tile") && tileCount < width * height)
 			{
-				// Otherwise, make it null.
-				tile_map[tileCount] = MapTile(gid, 0, -1);
+				// Read the Global-ID of the tile.
+				std::string gidText;
+				unsigned gid = 0;
+				if (reader.GetAttribute("gid", gidText))
+				{
+					sscanf(gidText.c_str(), "%u", &gid);
+				}
+
+				SetTiles(tileCount, &gid, 1);
+				tileCount++;
 			}
 
-			tileNode = dataNode->IterateChildren("tile", tileNode);
-			tileCount++;
+			if (!reader.Skip()) return;
 		}
 	}
 
-	void Layer::ParseBase64(const std::string &innerText) 
+	void Layer::ParseBase64(const char *text, size_t length) 
 	{
-		const std::string &text = Util::DecodeBase64(innerText);
-
-		// Temporary array of gids to be converted to map tiles.
-		unsigned *out = 0;
+		// The gids are decoded into the end of the tile array and converted
+		// in place from its front: a tile never overwrites a gid which was
+		// not read yet, so the tile array is the only allocation. Without
+		// tiles they are decoded where they are kept.
+		const size_t tileCount = width * height;
+		const size_t gidBytes = tileCount * 4;
+		unsigned char *gids = tile_map
+			? (unsigned char *)tile_map + sizeof(MapTile) * tileCount - gidBytes
+			: (unsigned char *)gid_map;
 
-		if (compression == TMX_COMPRESSION_ZLIB) 
+		long decoded;
+		if (compression == TMX_COMPRESSION_NONE)
 		{
-			// Use zlib to uncompress the layer into the temporary array of tiles.
-			uLongf outlen = width * height * 4;
-			out = (unsigned *)malloc(outlen);
-			uncompress(
-				(Bytef*)out, &outlen, 
-				(const Bytef*)text.c_str(), text.size());
-	
-		} 
-		else if (compression == TMX_COMPRESSION_GZIP) 
+			decoded = Util::DecodeBase64(text, length, gids, gidBytes);
+		}
+		else if (compression == TMX_COMPRESSION_ZSTD)
 		{
-			// Use the utility class for decompressing (which uses zlib)
-			out = (unsigned *)Util::DecompressGZIP(
-				text.c_str(), 
-				text.size(), 
-				width * height * 4);
-		} 
-		else 
+			decoded = Util::DecodeZstdBase64(text, length, gids, gidBytes);
+		}
+		else
 		{
-			out = (unsigned *)malloc(text.size());
-		
-			// Copy every gid into the temporary array since
-			// the decoded string is an array of 32-bit integers.
-			memcpy(out, text.c_str(), text.size());
+			// zlib and gzip are told apart by their header.
+			decoded = Util::DecodeCompressedBase64(text, length, gids, gidBytes);
 		}
 
-		// Convert the gids to map tiles.
-		for (int x = 0; x < width; x++)
+		if (decoded != (long)gidBytes)
 		{
-			for (int y = 0; y < height; y++)
+			has_error = true;
+			error_text = "Layer '" + name + "': the tile data could not be decoded.";
+			if (decoded < 0)
 			{
-				unsigned gid = out[y * width + x];
-
-				// Find the tileset index.
-				const int tilesetIndex = map->FindTilesetIndex(gid);
-				if (tilesetIndex != -1)
-				{
-					// If valid, set up the map tile with the tileset.
-					const Tmx::Tileset* tileset = map->GetTileset(tilesetIndex);
-					tile_map[y * width + x] = MapTile(gid, tileset->GetFirstGid(), tilesetIndex);
-				}
-				else
-				{
-					// Otherwise, make it null.
-					tile_map[y * width + x] = MapTile(gid, 0, -1);
-				}
+				decoded = 0;
 			}
+			memset(gids + decoded, 0, gidBytes - decoded);
 		}
 
-		// Free the temporary array from memory.
-		free(out);
+		// Convert the gids to map tiles, a block at a time.
+		unsigned block[1024];
+		for (size_t i = 0; tile_map && i < tileCount; i += 1024)
+		{
+			const size_t count = tileCount - i < 1024 ? tileCount - i : 1024;
+			memcpy(block, gids + i * 4, count * 4);
+			SetTiles(i, block, count);
+		}
 	}
 
-	void Layer::ParseCSV(const std::string &innerText) 
+	void Layer::ParseCSV(const char *text, size_t length) 
 	{
-		// Duplicate the string for use with C stdio.
-		char *csv = strdup(innerText.c_str());
-		
-		// Iterate through every token of ';' in the CSV string.
-		char *pch = strtok(csv, ",");
-		int tileCount = 0;
-		
-		while (pch) 
+		// Read the gids in a single pass. The values are separated by commas
+		// with any white space around them, and there is one per tile. Empty
+		// and blank fields, as left by a trailing comma, are skipped.
+		const char *p = text;
+		const char *end = text + length;
+		const size_t tileCount = width * height;
+		size_t count = 0;
+		bool valid = true;
+
+		// The gids are converted to map tiles a block at a time.
+		unsigned block[1024];
+		size_t blockCount = 0;
+
+		while (valid)
 		{
-			unsigned gid;
-			sscanf(pch, "%u", &gid);
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ','))
+			{
+				++p;
+			}
+			if (p == end)
+			{
+				break;
+			}
 
-			// Find the tileset index.
-			const int tilesetIndex = map->FindTilesetIndex(gid);
-			if (tilesetIndex != -1)
+			// Read the digits of the gid, it has to fit in 32 bits.
+			const char *digits = p;
+			unsigned long long value = 0;
+			while (p < end && (unsigned)(*p - '0') < 10 && value <= 0xFFFFFFFFull)
 			{
-				// If valid, set up the map tile with the tileset.
-				const Tmx::Tileset* tileset = map->GetTileset(tilesetIndex);
-				tile_map[tileCount] = MapTile(gid, tileset->GetFirstGid(), tilesetIndex);
+				value = value * 10 + (unsigned)(*p - '0');
+				++p;
 			}
-			else
+			if (p == digits || value > 0xFFFFFFFFull || count == tileCount)
 			{
-				// Otherwise, make it null.
-				tile_map[tileCount] = MapTile(gid, 0, -1);
+				valid = false;
+				break;
+			}
+			block[blockCount++] = (unsigned)value;
+			count++;
+			if (blockCount == 1024)
+			{
+				SetTiles(count - blockCount, block, blockCount);
+				blockCount = 0;
 			}
 
-			pch = strtok(NULL, ",");
-			tileCount++;
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n'))
+			{
+				++p;
+			}
+			if (p < end && *p != ',')
+			{
+				valid = false;
+			}
 		}
+		SetTiles(count - blockCount, block, blockCount);
 
-		free(csv);
+		if (!valid || count != tileCount)
+		{
+			has_error = true;
+			error_text = "Layer '" + name + "': the tile data could not be decoded.";
+		}
 	}
 };
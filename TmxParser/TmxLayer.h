@@ -27,16 +27,25 @@
 //-----------------------------------------------------------------------------
 #pragma once
 
+#include <stddef.h>
 #include <string>
 
 #include "TmxPropertySet.h"
 #include "TmxMapTile.h"
+#include "TmxThreads.h"
+
+#ifdef TMX_USE_THREADS
+#include <atomic>
+#include <mutex>
+#endif
 
 class TiXmlNode;
 
 namespace Tmx 
 {
 	class Map;
+	class StringPool;
+	class XmlReader;
 
 	//-------------------------------------------------------------------------
 	// Type used for the encoding of the layer data.
@@ -55,7 +64,21 @@ namespace Tmx
 	{
 		TMX_COMPRESSION_NONE,
 		TMX_COMPRESSION_ZLIB,
-		TMX_COMPRESSION_GZIP
+		TMX_COMPRESSION_GZIP,
+		TMX_COMPRESSION_ZSTD
+	};
+
+	//-------------------------------------------------------------------------
+	// The way the tiles of the layers are kept in memory.
+	//-------------------------------------------------------------------------
+	enum LayerStorageType
+	{
+		// A MapTile for every tile, 16 bytes per tile.
+		TMX_STORAGE_TILES,
+
+		// The raw gid of every tile, 4 bytes per tile. The tileset and the
+		// id of a tile are looked up when they are asked for.
+		TMX_STORAGE_GIDS
 	};
 
 	//-------------------------------------------------------------------------
@@ -64,6 +87,8 @@ namespace Tmx
 	//-------------------------------------------------------------------------
 	class Layer 
 	{
+		friend class BinaryMap;
+
 	private:
 		// Prevent copy constructor.
 		Layer(const Layer &_layer);
@@ -75,6 +100,15 @@ namespace Tmx
 		// Parse a layer node.
 		void Parse(const TiXmlNode *layerNode);
 
+		// Parse a layer element from a reader standing on its start. The
+		// tiles are decoded as soon as the data is read if decode is set,
+		// otherwise the base64 or CSV text is kept for Decode(). The strings
+		// of the properties are interned in the pool of the map.
+		void Parse(Tmx::XmlReader &reader, bool decode, Tmx::StringPool *stringPool);
+
+		// Get the unique id of the layer in the map, 0 if it has none.
+		int GetId() const { return id; }
+
 		// Get the name of the layer.
 		const std::string &GetName() const { return name; }
 
@@ -91,25 +125,58 @@ namespace Tmx
 		const Tmx::PropertySet &GetProperties() const { return properties; }
 
 		// Pick a specific tile from the list.
-		unsigned GetTileId(int x, int y) const { return tile_map[y * width + x].id; }
+		unsigned GetTileId(int x, int y) const 
+		{ Decode(); return tile_map ? tile_map[y * width + x].id : GetTile(x, y).id; }
 
 		// Get the tileset index for a tileset from the list.
-		int GetTileTilesetIndex(int x, int y) const { return tile_map[y * width + x].tilesetId; }
+		int GetTileTilesetIndex(int x, int y) const 
+		{ Decode(); return tile_map ? tile_map[y * width + x].tilesetId : GetTile(x, y).tilesetId; }
 
 		// Get whether a tile is flipped horizontally.
 		bool IsTileFlippedHorizontally(int x, int y) const 
-		{ return tile_map[y * width + x].flippedHorizontally; }
+		{ Decode(); return tile_map ? tile_map[y * width + x].flippedHorizontally : (gid_map[y * width + x] & FlippedHorizontallyFlag) != 0; }
 
 		// Get whether a tile is flipped vertically.
 		bool IsTileFlippedVertically(int x, int y) const 
-		{ return tile_map[y * width + x].flippedVertically; }
+		{ Decode(); return tile_map ? tile_map[y * width + x].flippedVertically : (gid_map[y * width + x] & FlippedVerticallyFlag) != 0; }
 
 		// Get whether a tile is flipped diagonally.
 		bool IsTileFlippedDiagonally(int x, int y) const
-		{ return tile_map[y * width + x].flippedDiagonally; }
+		{ Decode(); return tile_map ? tile_map[y * width + x].flippedDiagonally : (gid_map[y * width + x] & FlippedDiagonallyFlag) != 0; }
 
 		// Get a tile specific to the map.
-		const Tmx::MapTile& GetTile(int x, int y) const { return tile_map[y * width + x]; }
+		Tmx::MapTile GetTile(int x, int y) const 
+		{ Decode(); return tile_map ? tile_map[y * width + x] : MakeTile(gid_map[y * width + x]); }
+
+		// Get the gid of a tile, with its flip flags.
+		unsigned GetTileGid(int x, int y) const 
+		{ Decode(); return gid_map ? gid_map[y * width + x] : MakeGid(tile_map[y * width + x]); }
+
+		// Get the gids of all the tiles row by row from the top, with their
+		// flip flags. They are kept with TMX_STORAGE_GIDS only, otherwise
+		// this is NULL and CopyGids() has to be used.
+		const unsigned *GetGids() const { Decode(); return gid_map; }
+
+		// Get the gids of a row of tiles, see GetGids().
+		const unsigned *GetRowGids(int y) const { Decode(); return gid_map ? gid_map + y * width : NULL; }
+
+		// Copy the gids of a region of w by h tiles starting at x, y into
+		// out row by row, with either storage. Tiles beyond the layer are 0.
+		void CopyGids(int x, int y, int w, int h, unsigned *out) const;
+
+		// Get the way the tiles are kept in memory.
+		// See: LayerStorageType
+		Tmx::LayerStorageType GetStorage() const { return storage; }
+
+		// Decode the tiles of the layer if it was not done yet. With lazy
+		// decoding this is done by the first access to the tiles. Threads
+		// reading the same layer decode it once where the library uses
+		// threads, otherwise call it before reading it from several threads.
+		void Decode() const 
+		{ if (!is_decoded) const_cast< Layer* >(this)->DecodeData(); }
+
+		// Get whether the tiles of the layer were decoded.
+		bool IsDecoded() const { return is_decoded; }
 
 		// Get the type of encoding that was used for parsing the layer data.
 		// See: LayerEncodingType
@@ -125,13 +192,33 @@ namespace Tmx
 		// Set the zorder of the layer.
 		void SetZOrder( int z ) { zOrder = z; }
 
+		// Get whether the data of the layer could not be decoded. With lazy
+		// decoding this is only known once the layer is decoded, and the
+		// error is not reported by the map.
+		bool HasError() const { return has_error; }
+
+		// Get an error string containing the error in text format.
+		const std::string &GetErrorText() const { return error_text; }
+
 	private:
+		void AllocateTiles();
+		void DecodeData();
+		void ParseDataFormat(const char *encodingStr, const char *compressionStr);
 		void ParseXML(const TiXmlNode *dataNode);
-		void ParseBase64(const std::string &innerText);
-		void ParseCSV(const std::string &innerText);
+		void ParseXML(Tmx::XmlReader &reader);
+		void ParseBase64(const char *text, size_t length);
+		void ParseCSV(const char *text, size_t length);
+
+		// Set up count map tiles from their gids, starting at the tile first.
+		void SetTiles(size_t first, const unsigned *gids, size_t count);
+
+		// Set up a map tile from its gid, and the other way around.
+		Tmx::MapTile MakeTile(unsigned gid) const;
+		unsigned MakeGid(const Tmx::MapTile &tile) const;
 
 		const Tmx::Map *map;
 
+		int id;
 		std::string name;
 		
 		int width;
@@ -143,9 +230,31 @@ namespace Tmx
 
 		Tmx::PropertySet properties;
 
+		// Either of them is allocated, depending on the storage of the map.
+		Tmx::LayerStorageType storage;
 		Tmx::MapTile *tile_map;
+		unsigned *gid_map;
+
+		// False when gid_map points into a binary map, see BinaryMap.
+		bool owns_gids;
+
+		// The encoded text of the data until it is decoded, it lies in the
+		// buffer kept by the map unless it had to be joined into data_copy.
+		// The first thread to read a lazy layer decodes it under the mutex.
+#ifdef TMX_USE_THREADS
+		std::atomic< bool > is_decoded;
+		std::mutex decode_mutex;
+#else
+		bool is_decoded;
+#endif
+		const char *data_text;
+		size_t data_length;
+		std::string data_copy;
 
 		Tmx::LayerEncodingType encoding;
 		Tmx::LayerCompressionType compression;
+
+		bool has_error;
+		std::string error_text;
 	};
 };
@@ -27,16 +27,27 @@
 //-----------------------------------------------------------------------------
 #include <tinyxml.h>
 #include <stdio.h>
+#include <algorithm>
+
+#include "TmxThreads.h"
+
+// Layers are decoded on several threads where the standard library has them.
+#ifdef TMX_USE_THREADS
+#include <atomic>
+#include <system_error>
+#include <thread>
+#endif
 
 #include "TmxMap.h"
 #include "TmxTileset.h"
 #include "TmxLayer.h"
+#include "TmxMapTile.h"
 #include "TmxObjectGroup.h"
+#include "TmxObject.h"
 #include "TmxImageLayer.h"
-
-#ifdef USE_SDL2_LOAD
-#include <SDL.h>
-#endif
+#include "TmxFileBuffer.h"
+#include "TmxBinaryMap.h"
+#include "TmxXmlReader.h"
 
 using std::vector;
 using std::string;
@@ -44,7 +55,9 @@ using std::string;
 namespace Tmx 
 {
 	Map::Map() 
-		: file_name()
+		: string_pool()
+		, arena()
+		, file_name()
 		, file_path()
 		, version(0.0)
 		, orientation(TMX_MO_ORTHOGONAL)
@@ -55,6 +68,20 @@ namespace Tmx
 		, layers()
 		, object_groups()
 		, tilesets() 
+		, tileset_first_gids()
+		, tileset_indexes()
+		, layer_names()
+		, layer_ids()
+		, image_layer_ids()
+		, object_group_names()
+		, object_group_ids()
+		, object_ids()
+		, tileset_names()
+		, layer_storage(TMX_STORAGE_TILES)
+		, lazy_decoding(false)
+		, file_buffer()
+		, text_copy()
+		, decode_threads(1)
 		, has_error(false)
 		, error_code(0)
 		, error_text()
@@ -62,60 +89,15 @@ namespace Tmx
 
 	Map::~Map() 
 	{
-		// Iterate through all of the object groups and delete each of them.
-		vector< ObjectGroup* >::iterator ogIter;
-		for (ogIter = object_groups.begin(); ogIter != object_groups.end(); ++ogIter) 
-		{
-			ObjectGroup *objectGroup = (*ogIter);
-			
-			if (objectGroup)
-			{
-				delete objectGroup;
-				objectGroup = NULL;
-			}
-		}
-
-		// Iterate through all of the layers and delete each of them.
-		vector< Layer* >::iterator lIter;
-		for (lIter = layers.begin(); lIter != layers.end(); ++lIter) 
-		{
-			Layer *layer = (*lIter);
-
-			if (layer) 
-			{
-				delete layer;
-				layer = NULL;
-			}
-		}
-
-		// Iterate through all of the layers and delete each of them.
-		vector< ImageLayer* >::iterator ilIter;
-		for (ilIter = image_layers.begin(); ilIter != image_layers.end(); ++ilIter) 
-		{
-			ImageLayer *layer = (*ilIter);
-
-			if (layer) 
-			{
-				delete layer;
-				layer = NULL;
-			}
-		}
-
-		// Iterate through all of the tilesets and delete each of them.
-		vector< Tileset* >::iterator tsIter;
-		for (tsIter = tilesets.begin(); tsIter != tilesets.end(); ++tsIter) 
-		{
-			Tileset *tileset = (*tsIter);
-			
-			if (tileset) 
-			{
-				delete tileset;
-				tileset = NULL;
-			}
-		}
+		// The elements of the map are destroyed by its arena.
 	}
 
 	void Map::ParseFile(const string &fileName) 
+	{
+		ParseFile(fileName, ParseOptions());
+	}
+
+	void Map::ParseFile(const string &fileName, const ParseOptions &options) 
 	{
 		file_name = fileName;
 
@@ -131,36 +113,16 @@ namespace Tmx
 			file_path = "";
 		}
 
-		char* fileText;
-		int fileSize;
-
-		// Open the file for reading.
-#ifdef USE_SDL2_LOAD
-		SDL_RWops * file = SDL_RWFromFile (fileName.c_str(), "rb");
-#else
-		FILE *file = fopen(fileName.c_str(), "rb");
-#endif
-
-		// Check if the file could not be opened.
-		if (!file) 
+		// Map or read the file, its content is parsed where it lies.
+		const unsigned char openError = file_buffer.Open(fileName);
+		if (openError == TMX_COULDNT_OPEN)
 		{
 			has_error = true;
 			error_code = TMX_COULDNT_OPEN;
 			error_text = "Could not open the file.";
 			return;
 		}
-	
-		// Find out the file size.	
-#ifdef USE_SDL2_LOAD
-		fileSize = file->size(file);
-#else
-		fseek(file, 0, SEEK_END);
-		fileSize = ftell(file);
-		fseek(file, 0, SEEK_SET);
-#endif
-		
-		// Check if the file size is valid.
-		if (fileSize <= 0)
+		if (openError == TMX_INVALID_FILE_SIZE)
 		{
 			has_error = true;
 			error_code = TMX_INVALID_FILE_SIZE;
@@ -168,55 +130,90 @@ namespace Tmx
 			return;
 		}
 
-		// Allocate memory for the file and read it into the memory.
-		fileText = new char[fileSize + 1];
-		fileText[fileSize] = 0;
-#ifdef USE_SDL2_LOAD
-		file->read(file, fileText, 1, fileSize);
-#else
-		fread(fileText, 1, fileSize, file);
-#endif
-
-#ifdef USE_SDL2_LOAD
-		file->close(file);
-#else
-		fclose(file);
-#endif
+		// Binary maps are read as they are, the layers keeping gids use
+		// them right from the file.
+		if (BinaryMap::IsBinaryMap(file_buffer.GetData(), file_buffer.GetSize()))
+		{
+			const bool gidsInPlace = layer_storage == TMX_STORAGE_GIDS;
+			BinaryMap::Read(*this, file_buffer.GetData(), file_buffer.GetSize(), options, gidsInPlace);
+			if (!gidsInPlace)
+			{
+				file_buffer.Close();
+			}
+			return;
+		}
 
-		// Copy the contents into a C++ string and delete it from memory.
-		std::string text(fileText, fileText+fileSize);
-		delete [] fileText;
+		ParseContent(file_buffer.GetData(), file_buffer.GetSize(), options);
 
-		ParseText(text);		
+		// Lazy layers are decoded from the content later on.
+		if (!lazy_decoding)
+		{
+			file_buffer.Close();
+		}
 	}
 
 	void Map::ParseText(const string &text) 
 	{
-		// Create a tiny xml document and use it to parse the text.
-		TiXmlDocument doc;
-		doc.Parse(text.c_str());
-	
-		// Check for parsing errors.
-		if (doc.Error()) 
+		ParseBuffer(text.c_str(), text.size(), ParseOptions());
+	}
+
+	void Map::ParseText(const string &text, const ParseOptions &options) 
+	{
+		ParseBuffer(text.c_str(), text.size(), options);
+	}
+
+	void Map::ParseBuffer(const char *data, size_t size)
+	{
+		ParseBuffer(data, size, ParseOptions());
+	}
+
+	void Map::ParseBuffer(const char *data, size_t size, const ParseOptions &options)
+	{
+		// Binary maps are read from a copy, which is aligned to their words.
+		if (BinaryMap::IsBinaryMap(data, size))
+		{
+			text_copy.assign(data, size);
+			BinaryMap::Read(*this, text_copy.data(), text_copy.size(), options, true);
+			return;
+		}
+
+		// Lazy layers are decoded from a copy, the buffer may be gone by
+		// the time they are.
+		if (lazy_decoding)
+		{
+			text_copy.assign(data, size);
+			ParseContent(text_copy.data(), text_copy.size(), options);
+			return;
+		}
+		ParseContent(data, size, options);
+	}
+
+	void Map::ParseContent(const char *data, size_t size, const ParseOptions &options)
+	{
+		// Read the document node by node, no tree of it is built.
+		XmlReader reader(data, size);
+
+		// Find the map element.
+		XmlNodeType type;
+		while ((type = reader.Read()) == XML_TEXT) {}
+		if (type != XML_START_ELEMENT || !reader.IsElement("map"))
 		{
 			has_error = true;
 			error_code = TMX_PARSING_ERROR;
-			error_text = doc.ErrorDesc();
+			error_text = reader.HasError() ? reader.GetErrorText() : "The map element is missing.";
 			return;
 		}
 
-		TiXmlNode *mapNode = doc.FirstChild("map");
-		TiXmlElement* mapElem = mapNode->ToElement();
-
 		// Read the map attributes.
-		mapElem->Attribute("version", &version);
-		mapElem->Attribute("width", &width);
-		mapElem->Attribute("height", &height);
-		mapElem->Attribute("tilewidth", &tile_width);
-		mapElem->Attribute("tileheight", &tile_height);
+		version = reader.GetDoubleAttribute("version", version);
+		width = reader.GetIntAttribute("width", width);
+		height = reader.GetIntAttribute("height", height);
+		tile_width = reader.GetIntAttribute("tilewidth", tile_width);
+		tile_height = reader.GetIntAttribute("tileheight", tile_height);
 
 		// Read the orientation
-		std::string orientationStr = mapElem->Attribute("orientation");
+		std::string orientationStr;
+		reader.GetAttribute("orientation", orientationStr);
 
 		if (!orientationStr.compare("orthogonal")) 
 		{
@@ -231,99 +228,337 @@ namespace Tmx
 			orientation = TMX_MO_STAGGERED;
 		}
 		
+		// The layers are decoded on the decoding threads once the map is
+		// read, all of the tilesets are known by then.
+		const bool decodeLater = !lazy_decoding && decode_threads != 1;
+		vector< Layer* > pending;
 
-		const TiXmlNode *node = mapElem->FirstChild();
 		int zOrder = 0;
-		while( node )
+		while ((type = reader.Read()) != XML_END_ELEMENT)
 		{
-			// Read the map properties.
-			if( strcmp( node->Value(), "properties" ) == 0 )
+			if (type == XML_TEXT)
 			{
-				properties.Parse(node);			
+				continue;
 			}
-
-			// Iterate through all of the tileset elements.
-			if( strcmp( node->Value(), "tileset" ) == 0 )
+			if (type != XML_START_ELEMENT)
 			{
-				// Allocate a new tileset and parse it.
-				Tileset *tileset = new Tileset();
-				tileset->Parse(node->ToElement());
+				break;
+			}
 
-				// Add the tileset to the list.
-				tilesets.push_back(tileset);
+			// Step over the layers and object groups left out by the
+			// options, they keep their place in the zorder.
+			const bool isLayer = reader.IsElement("layer");
+			const bool isImageLayer = reader.IsElement("imagelayer");
+			const bool isObjectGroup = reader.IsElement("objectgroup");
+			if (isLayer || isImageLayer || isObjectGroup)
+			{
+				std::string elementName;
+				reader.GetAttribute("name", elementName);
+				const ParseElementType elementType = isLayer ? TMX_PARSE_LAYERS
+					: isImageLayer ? TMX_PARSE_IMAGE_LAYERS : TMX_PARSE_OBJECT_GROUPS;
+				if (!options.IsParsed(elementType, elementName))
+				{
+					if (!reader.Skip()) break;
+					++zOrder;
+					continue;
+				}
 			}
 
-			// Iterate through all of the layer elements.			
-			if( strcmp( node->Value(), "layer" ) == 0 )
+			// Iterate through all of the layer elements, their tiles
+			// are decoded as soon as they are read.
+			if (isLayer)
 			{
 				// Allocate a new layer and parse it.
-				Layer *layer = new Layer(this);
-				layer->Parse(node);
+				Layer *layer = arena.New< Layer >(this);
+				layer->Parse(reader, !lazy_decoding && !decodeLater, &string_pool);
 				layer->SetZOrder( zOrder );
 				++zOrder;
 
 				// Add the layer to the list.
-				layers.push_back(layer);
+				AddLayer(layer);
+				if (decodeLater && !layer->IsDecoded())
+				{
+					pending.push_back(layer);
+				}
+				continue;
+			}
+
+			// The other elements are small, each of them is read into
+			// a document of its own.
+			if (!reader.IsElement("properties") && !reader.IsElement("tileset")
+				&& !reader.IsElement("imagelayer") && !reader.IsElement("objectgroup"))
+			{
+				if (!reader.Skip()) break;
+				continue;
+			}
+
+			// The properties of the tiles of a tileset may be left out.
+			std::string tilesetName;
+			reader.GetAttribute("name", tilesetName);
+			const bool parseTiles = options.IsParsed(TMX_PARSE_TILE_PROPERTIES, tilesetName);
+
+			TiXmlDocument doc;
+			if (!reader.ReadFragment(doc)) break;
+			const TiXmlNode *node = doc.FirstChild();
+
+			// Read the map properties.
+			if( strcmp( node->Value(), "properties" ) == 0 )
+			{
+				properties.Parse(node, &string_pool);			
+			}
+
+			// Iterate through all of the tileset elements.
+			if( strcmp( node->Value(), "tileset" ) == 0 )
+			{
+				// Allocate a new tileset and parse it.
+				Tileset *tileset = arena.New< Tileset >(&arena);
+				tileset->Parse(node->ToElement(), parseTiles, &string_pool);
+
+				// Add the tileset to the list.
+				AddTileset(tileset);
 			}
 
 			// Iterate through all of the imagen layer elements.			
 			if( strcmp( node->Value(), "imagelayer" ) == 0 )
 			{
 				// Allocate a new layer and parse it.
-				ImageLayer *imageLayer = new ImageLayer(this);
-				imageLayer->Parse(node);
+				ImageLayer *imageLayer = arena.New< ImageLayer >(this);
+				imageLayer->Parse(node, &string_pool);
 				imageLayer->SetZOrder( zOrder );
 				++zOrder;
 
 				// Add the layer to the list.
-				image_layers.push_back(imageLayer);
+				AddImageLayer(imageLayer);
 			}
 
 			// Iterate through all of the objectgroup elements.
 			if( strcmp( node->Value(), "objectgroup" ) == 0 )
 			{
 				// Allocate a new object group and parse it.
-				ObjectGroup *objectGroup = new ObjectGroup();
-				objectGroup->Parse(node);
+				ObjectGroup *objectGroup = arena.New< ObjectGroup >(&arena);
+				objectGroup->Parse(node, &string_pool);
 				objectGroup->SetZOrder( zOrder );
 				++zOrder;
 		
 				// Add the object group to the list.
-				object_groups.push_back(objectGroup);
+				AddObjectGroup(objectGroup);
+			}
+		}
+
+		DecodeLayers(pending);
+
+		// Report the first layer which could not be decoded.
+		for (unsigned int i = 0; i < layers.size() && !has_error; ++i)
+		{
+			if (layers[i]->HasError())
+			{
+				has_error = true;
+				error_code = TMX_INVALID_LAYER_DATA;
+				error_text = layers[i]->GetErrorText();
 			}
+		}
+
+		// Check for parsing errors.
+		if (reader.HasError()) 
+		{
+			has_error = true;
+			error_code = TMX_PARSING_ERROR;
+			error_text = reader.GetErrorText();
+		}
+	}
 
-			node = node->NextSibling();
+#ifdef TMX_USE_THREADS
+	// Decode the pending layers one after another until none is left.
+	static void DecodeLayersWorker(const vector< Layer* > *pending, std::atomic< size_t > *next)
+	{
+		size_t index;
+		while ((index = (*next)++) < pending->size())
+		{
+			(*pending)[index]->Decode();
 		}
 	}
+#endif
 
-	int Map::FindTilesetIndex(int gid) const
+	void Map::DecodeLayers(const vector< Layer* > &pending) const
 	{
-		// Clean up the flags from the gid (thanks marwes91).
-		gid &= ~(FlippedHorizontallyFlag | FlippedVerticallyFlag | FlippedDiagonallyFlag);
+#ifdef TMX_USE_THREADS
+		size_t threadCount = decode_threads > 0 ? decode_threads : std::thread::hardware_concurrency();
+		if (threadCount > pending.size())
+		{
+			threadCount = pending.size();
+		}
 
-		for (int i = tilesets.size() - 1; i > -1; --i) 
+		// This thread is one of the workers.
+		std::atomic< size_t > next(0);
+		vector< std::thread > workers;
+		for (size_t i = 1; i < threadCount; ++i)
 		{
-			// If the gid beyond the tileset gid return its index.
-			if (gid >= tilesets[i]->GetFirstGid()) 
+			try
+			{
+				workers.push_back(std::thread(DecodeLayersWorker, &pending, &next));
+			}
+			catch (const std::system_error &)
 			{
-				return i;
+				// The threads which could be started do the work.
+				break;
 			}
 		}
-		
-		return -1;
+		DecodeLayersWorker(&pending, &next);
+		for (size_t i = 0; i < workers.size(); ++i)
+		{
+			workers[i].join();
+		}
+#else
+		for (size_t i = 0; i < pending.size(); ++i)
+		{
+			pending[i]->Decode();
+		}
+#endif
 	}
 
-	const Tileset *Map::FindTileset(int gid) const 
+	// Find an element in one of the lookups, NULL if it is not there.
+	template< typename Key, typename Element >
+	static const Element *FindIn(const std::map< Key, const Element* > &lookup, const Key &key)
+	{
+		typename std::map< Key, const Element* >::const_iterator iter = lookup.find(key);
+		return iter != lookup.end() ? iter->second : NULL;
+	}
+
+	void Map::AddLayer(Layer *layer)
+	{
+		// Only the first element of a name is found by it.
+		layer_names.insert(std::make_pair(layer->GetName(), layer));
+		if (layer->GetId() != 0)
+		{
+			layer_ids[layer->GetId()] = layer;
+		}
+
+		layers.push_back(layer);
+	}
+
+	void Map::AddImageLayer(ImageLayer *imageLayer)
+	{
+		if (imageLayer->GetId() != 0)
+		{
+			image_layer_ids[imageLayer->GetId()] = imageLayer;
+		}
+
+		image_layers.push_back(imageLayer);
+	}
+
+	void Map::AddObjectGroup(ObjectGroup *objectGroup)
+	{
+		object_group_names.insert(std::make_pair(objectGroup->GetName(), objectGroup));
+		if (objectGroup->GetId() != 0)
+		{
+			object_group_ids[objectGroup->GetId()] = objectGroup;
+		}
+		for (int i = 0; i < objectGroup->GetNumObjects(); ++i)
+		{
+			const Object *object = objectGroup->GetObject(i);
+			if (object->GetId() != 0)
+			{
+				object_ids[object->GetId()] = object;
+			}
+		}
+
+		object_groups.push_back(objectGroup);
+	}
+
+	void Map::AddTileset(Tileset *tileset)
+	{
+		tileset_names.insert(std::make_pair(tileset->GetName(), tileset));
+
+		// Keep the first gids sorted, a tileset with the same first gid as
+		// an earlier one goes after it so that the last one wins.
+		const unsigned firstGid = tileset->GetFirstGid();
+		const size_t position = std::upper_bound(tileset_first_gids.begin(), tileset_first_gids.end(), firstGid)
+			- tileset_first_gids.begin();
+		tileset_first_gids.insert(tileset_first_gids.begin() + position, firstGid);
+		tileset_indexes.insert(tileset_indexes.begin() + position, (int)tilesets.size());
+
+		tilesets.push_back(tileset);
+	}
+
+	int Map::FindTilesetIndex(int gid) const
+	{
+		// Clean up the flags from the gid (thanks marwes91).
+		const unsigned id = (unsigned)gid & ~(FlippedHorizontallyFlag | FlippedVerticallyFlag | FlippedDiagonallyFlag);
+
+		// Find the last tileset whose first gid is not beyond the gid.
+		const size_t position = std::upper_bound(tileset_first_gids.begin(), tileset_first_gids.end(), id)
+			- tileset_first_gids.begin();
+		return position > 0 ? tileset_indexes[position - 1] : -1;
+	}
+
+	void Map::FindTilesetIndexes(const unsigned *gids, size_t count, int *tilesetIndexes) const
 	{
-		for (int i = tilesets.size() - 1; i > -1; --i) 
+		const unsigned flags = FlippedHorizontallyFlag | FlippedVerticallyFlag | FlippedDiagonallyFlag;
+
+		// The gids from runFirst up to runEnd (excluded) have the same tileset.
+		unsigned runFirst = 0;
+		unsigned runEnd = 0;
+		int runIndex = -1;
+
+		for (size_t i = 0; i < count; ++i)
 		{
-			// If the gid beyond the tileset gid return it.
-			if (gid >= tilesets[i]->GetFirstGid()) 
+			const unsigned id = gids[i] & ~flags;
+			if (id - runFirst >= runEnd - runFirst)
 			{
-				return tilesets[i];
+				const size_t position = std::upper_bound(tileset_first_gids.begin(), tileset_first_gids.end(), id)
+					- tileset_first_gids.begin();
+				if (position == 0)
+				{
+					// Empty tiles do not break the run.
+					tilesetIndexes[i] = -1;
+					continue;
+				}
+				runFirst = tileset_first_gids[position - 1];
+				runEnd = position < tileset_first_gids.size() ? tileset_first_gids[position] : flags;
+				runIndex = tileset_indexes[position - 1];
 			}
+			tilesetIndexes[i] = runIndex;
 		}
-		
-		return NULL;
+	}
+
+	const Tileset *Map::FindTileset(int gid) const 
+	{
+		const int index = FindTilesetIndex(gid);
+		return index != -1 ? tilesets[index] : NULL;
+	}
+
+	const Tileset *Map::FindTileset(const string &name) const
+	{
+		return FindIn(tileset_names, name);
+	}
+
+	const Layer *Map::FindLayer(const string &name) const
+	{
+		return FindIn(layer_names, name);
+	}
+
+	const Layer *Map::FindLayerById(int id) const
+	{
+		return FindIn(layer_ids, id);
+	}
+
+	const ImageLayer *Map::FindImageLayerById(int id) const
+	{
+		return FindIn(image_layer_ids, id);
+	}
+
+	const ObjectGroup *Map::FindObjectGroup(const string &name) const
+	{
+		return FindIn(object_group_names, name);
+	}
+
+	const ObjectGroup *Map::FindObjectGroupById(int id) const
+	{
+		return FindIn(object_group_ids, id);
+	}
+
+	const Object *Map::FindObjectById(int id) const
+	{
+		return FindIn(object_ids, id);
 	}
 };
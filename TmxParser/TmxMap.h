@@ -27,16 +27,24 @@
 //-----------------------------------------------------------------------------
 #pragma once
 
+#include <stddef.h>
+#include <map>
 #include <vector>
 #include <string>
 
+#include "TmxArena.h"
+#include "TmxStringPool.h"
 #include "TmxPropertySet.h"
+#include "TmxLayer.h"
+#include "TmxFileBuffer.h"
+#include "TmxParseOptions.h"
 
 namespace Tmx 
 {
 	class Layer;
 	class ImageLayer;
 	class ObjectGroup;
+	class Object;
 	class Tileset;
 
 	//-------------------------------------------------------------------------
@@ -52,7 +60,10 @@ namespace Tmx
 		TMX_PARSING_ERROR = 0x02,
 		
 		// The size of the file is invalid.
-		TMX_INVALID_FILE_SIZE = 0x04
+		TMX_INVALID_FILE_SIZE = 0x04,
+
+		// The data of a layer could not be decoded.
+		TMX_INVALID_LAYER_DATA = 0x08
 	};
 
 	//-------------------------------------------------------------------------
@@ -77,6 +88,8 @@ namespace Tmx
 	//-------------------------------------------------------------------------
 	class Map 
 	{
+		friend class BinaryMap;
+
 	private:
 		// Prevent copy constructor.
 		Map(const Map &_map);
@@ -88,10 +101,52 @@ namespace Tmx
 		// Read a file and parse it.
 		// Note: use '/' instead of '\\' as it is using '/' to find the path.
 		void ParseFile(const std::string &fileName);
+
+		// Read a file and parse the elements allowed by the options.
+		void ParseFile(const std::string &fileName, const Tmx::ParseOptions &options);
 		
 		// Parse text containing TMX formatted XML.
 		void ParseText(const std::string &text);
 
+		// Parse the elements allowed by the options of text containing TMX
+		// formatted XML.
+		void ParseText(const std::string &text, const Tmx::ParseOptions &options);
+
+		// Parse a buffer of size bytes containing TMX formatted XML.
+		// The buffer is read in place and the tiles of every layer are
+		// decoded as soon as its data is read, see SetLazyDecoding().
+		void ParseBuffer(const char *data, size_t size);
+
+		// Parse the elements allowed by the options of a buffer.
+		void ParseBuffer(const char *data, size_t size, const Tmx::ParseOptions &options);
+
+		// Set the way the tiles of the layers are kept in memory, before
+		// parsing. TMX_STORAGE_GIDS takes a quarter of the memory but looks
+		// up the tileset of a tile every time it is asked for.
+		void SetLayerStorage(Tmx::LayerStorageType storage) { layer_storage = storage; }
+
+		// Get the way the tiles of the layers are kept in memory.
+		Tmx::LayerStorageType GetLayerStorage() const { return layer_storage; }
+
+		// Set whether the base64 and CSV data of the layers is decoded when
+		// their tiles are first needed rather than while parsing, before
+		// parsing. The map then keeps the content of the file, or a copy
+		// of the parsed text, until it is destroyed.
+		void SetLazyDecoding(bool lazy) { lazy_decoding = lazy; }
+
+		// Get whether the layers are decoded when they are first needed.
+		bool GetLazyDecoding() const { return lazy_decoding; }
+
+		// Set the amount of threads decoding the base64 and CSV data of the
+		// layers, before parsing. With more than one, the layers are
+		// decoded side by side once the whole map was read, and 0 uses as
+		// many threads as the hardware runs. The default is 1, which
+		// decodes every layer on the parsing thread as it is read.
+		void SetDecodeThreads(int count) { decode_threads = count; }
+
+		// Get the amount of threads decoding the layers.
+		int GetDecodeThreads() const { return decode_threads; }
+
 		// Get the filename used to read the map.
 		const std::string &GetFilename() { return file_name; }
 
@@ -125,6 +180,12 @@ namespace Tmx
 		// Get the whole layers collection.
 		const std::vector< Tmx::Layer* > &GetLayers() const { return layers; }
 
+		// Find the first layer with a name, NULL if there is none.
+		const Tmx::Layer *FindLayer(const std::string &name) const;
+
+		// Find the layer with a certain id, NULL if there is none.
+		const Tmx::Layer *FindLayerById(int id) const;
+
 		// Get the object group at a certain index.
 		const Tmx::ObjectGroup *GetObjectGroup(int index) const { return object_groups.at(index); }
 
@@ -134,6 +195,16 @@ namespace Tmx
 		// Get the whole object group collection.
 		const std::vector< Tmx::ObjectGroup* > &GetObjectGroups() const { return object_groups; }
 
+		// Find the first object group with a name, NULL if there is none.
+		const Tmx::ObjectGroup *FindObjectGroup(const std::string &name) const;
+
+		// Find the object group with a certain id, NULL if there is none.
+		const Tmx::ObjectGroup *FindObjectGroupById(int id) const;
+
+		// Find the object with a certain id in any of the object groups,
+		// NULL if there is none.
+		const Tmx::Object *FindObjectById(int id) const;
+
 		// Get the layer at a certain index.
 		const Tmx::ImageLayer *GetImageLayer(int index) const { return image_layers.at(index); }
 
@@ -143,12 +214,25 @@ namespace Tmx
 		// Get the whole layers collection.
 		const std::vector< Tmx::ImageLayer* > &GetImageLayers() const { return image_layers; }
 
+		// Find the image layer with a certain id, NULL if there is none.
+		// The layers, image layers and object groups of a map share their
+		// ids, an id is only found by the lookup of its kind.
+		const Tmx::ImageLayer *FindImageLayerById(int id) const;
+
 		// Find the tileset index for a tileset using a tile gid.
 		int FindTilesetIndex(int gid) const;
 
+		// Find the tileset indexes of count gids at once, -1 for the gids
+		// which belong to no tileset. The tileset of a run of gids is only
+		// looked up once, which makes this much faster for whole layers.
+		void FindTilesetIndexes(const unsigned *gids, size_t count, int *tilesetIndexes) const;
+
 		// Find a tileset for a specific gid.
 		const Tmx::Tileset *FindTileset(int gid) const;
 
+		// Find the first tileset with a name, NULL if there is none.
+		const Tmx::Tileset *FindTileset(const std::string &name) const;
+
 		// Get a tileset by an index.
 		const Tmx::Tileset *GetTileset(int index) const { return tilesets.at(index); }
 
@@ -170,7 +254,37 @@ namespace Tmx
 		// Get the property set.
 		const Tmx::PropertySet &GetProperties() const { return properties; }
 
+		// Get the pool of the property names and values and of the object
+		// names and types, to look them up once and compare their pointers
+		// (see PropertySet::GetInternedProperty()).
+		const Tmx::StringPool &GetStringPool() const { return string_pool; }
+
 	private:
+		// Add a layer to the list and to the lookups by name and by id.
+		void AddLayer(Tmx::Layer *layer);
+
+		// Add an image layer to the list and to the lookup by id.
+		void AddImageLayer(Tmx::ImageLayer *imageLayer);
+
+		// Add an object group to the list and to the lookups by name and by
+		// id, along with its objects.
+		void AddObjectGroup(Tmx::ObjectGroup *objectGroup);
+
+		// Add a tileset to the list and to the gid and name lookups.
+		void AddTileset(Tmx::Tileset *tileset);
+
+		// Parse the content of the map, which stays valid while it is parsed.
+		void ParseContent(const char *data, size_t size, const Tmx::ParseOptions &options);
+
+		// Decode layers on the decoding threads.
+		void DecodeLayers(const std::vector< Tmx::Layer* > &pending) const;
+
+		// The strings interned by the elements of the map, and the arena
+		// they are made in and destroyed along with. These come first to be
+		// destroyed last, the elements before the strings they point to.
+		Tmx::StringPool string_pool;
+		Tmx::Arena arena;
+
 		std::string file_name;
 		std::string file_path;
 
@@ -187,6 +301,30 @@ namespace Tmx
 		std::vector< Tmx::ObjectGroup* > object_groups;
 		std::vector< Tmx::Tileset* > tilesets;
 
+		// The first gids of the tilesets in ascending order, and the index
+		// of the tileset of each of them, for finding tilesets by gid.
+		std::vector< unsigned > tileset_first_gids;
+		std::vector< int > tileset_indexes;
+
+		// The first element of each name, and the elements which have an id,
+		// built as they are parsed. Ids start at 1, 0 is for no id.
+		std::map< std::string, const Tmx::Layer* > layer_names;
+		std::map< int, const Tmx::Layer* > layer_ids;
+		std::map< int, const Tmx::ImageLayer* > image_layer_ids;
+		std::map< std::string, const Tmx::ObjectGroup* > object_group_names;
+		std::map< int, const Tmx::ObjectGroup* > object_group_ids;
+		std::map< int, const Tmx::Object* > object_ids;
+		std::map< std::string, const Tmx::Tileset* > tileset_names;
+
+		Tmx::LayerStorageType layer_storage;
+
+		// The content the layers are decoded from, with lazy decoding.
+		bool lazy_decoding;
+		Tmx::FileBuffer file_buffer;
+		std::string text_copy;
+
+		int decode_threads;
+
 		bool has_error;
 		unsigned char error_code;
 		std::string error_text;
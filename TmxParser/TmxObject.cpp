@@ -31,12 +31,34 @@
 #include "TmxPolygon.h"
 #include "TmxPolyline.h"
 #include "TmxEllipse.h"
+#include "TmxArena.h"
+#include "TmxStringPool.h"
 
 namespace Tmx 
 {
 	Object::Object() 
-		: name()
-		, type()
+		: arena(NULL)
+		, own_pool(NULL)
+		, id(0)
+		, name(StringPool::GetEmpty())
+		, type(StringPool::GetEmpty())
+		, x(0)
+		, y(0)
+		, width(0)
+		, height(0)
+		, gid(0)
+		, ellipse(0)
+		, polygon(0)
+		, polyline(0)
+		, properties() 
+	{}
+
+	Object::Object(Arena *_arena) 
+		: arena(_arena)
+		, own_pool(NULL)
+		, id(0)
+		, name(StringPool::GetEmpty())
+		, type(StringPool::GetEmpty())
 		, x(0)
 		, y(0)
 		, width(0)
@@ -50,6 +72,14 @@ namespace Tmx
 
 	Object::~Object() 
 	{
+		delete own_pool;
+
+		// The shapes made in an arena are destroyed by it.
+		if (arena)
+		{
+			return;
+		}
+
 		if (ellipse != 0)
 		{
 			delete ellipse;
@@ -68,15 +98,31 @@ namespace Tmx
 	}
 
 	void Object::Parse(const TiXmlNode *objectNode) 
+	{
+		Parse(objectNode, NULL);
+	}
+
+	void Object::Parse(const TiXmlNode *objectNode, StringPool *stringPool) 
 	{
 		const TiXmlElement *objectElem = objectNode->ToElement();
 
+		// An object parsed on its own keeps its strings in its own pool.
+		if (!stringPool)
+		{
+			if (!own_pool)
+			{
+				own_pool = new StringPool();
+			}
+			stringPool = own_pool;
+		}
+
 		// Read the attributes of the object.
+		objectElem->Attribute("id", &id);
 		const char *tempName = objectElem->Attribute("name");
 		const char *tempType = objectElem->Attribute("type");
 		
-		if (tempName) name = tempName;
-		if (tempType) type = tempType;
+		if (tempName) name = stringPool->Intern(tempName);
+		if (tempType) type = stringPool->Intern(tempType);
 		
 		objectElem->Attribute("x", &x);
 		objectElem->Attribute("y", &y);
@@ -88,29 +134,29 @@ namespace Tmx
 		const TiXmlNode *ellipseNode = objectNode->FirstChild("ellipse");
 		if (ellipseNode)
 		{
-			if (ellipse != 0)
+			if (ellipse != 0 && !arena)
 				delete ellipse;
 
-			ellipse = new Ellipse(x,y,width,height);			
+			ellipse = arena ? arena->New< Ellipse >(x, y, width, height) : new Ellipse(x,y,width,height);			
 		}
 
 		// Read the Polygon and Polyline of the object if there are any.
 		const TiXmlNode *polygonNode = objectNode->FirstChild("polygon");
 		if (polygonNode)
 		{
-			if (polygon != 0)
+			if (polygon != 0 && !arena)
 				delete polygon;
 
-			polygon = new Polygon();
+			polygon = arena ? arena->New< Polygon >() : new Polygon();
 			polygon->Parse(polygonNode);
 		}
 		const TiXmlNode *polylineNode = objectNode->FirstChild("polyline");
 		if (polylineNode)
 		{
-			if (polyline != 0)
+			if (polyline != 0 && !arena)
 				delete polyline;
 
-			polyline = new Polyline();
+			polyline = arena ? arena->New< Polyline >() : new Polyline();
 			polyline->Parse(polylineNode);
 		}
 
@@ -118,7 +164,7 @@ namespace Tmx
 		const TiXmlNode *propertiesNode = objectNode->FirstChild("properties");
 		if (propertiesNode) 
 		{
-			properties.Parse(propertiesNode);
+			properties.Parse(propertiesNode, stringPool);
 		}
 	}
 };
@@ -35,6 +35,8 @@ class TiXmlNode;
 
 namespace Tmx 
 {
+	class Arena;
+	class StringPool;
 	class Ellipse;
 	class Polygon;
 	class Polyline;
@@ -44,18 +46,40 @@ namespace Tmx
 	//-------------------------------------------------------------------------
 	class Object 
 	{
+		friend class BinaryMap;
+
+	private:
+		// Prevent copy constructor.
+		Object(const Object &_object);
+		Object &operator=(const Object &_object);
+
 	public:
 		Object();
+
+		// Make an object whose shapes are made in an arena, they are left
+		// for the arena to destroy.
+		Object(Tmx::Arena *_arena);
 		~Object();
 
 		// Parse an object node.
 		void Parse(const TiXmlNode *objectNode);
+
+		// Parse an object node, interning its strings in a pool which
+		// outlives the object.
+		void Parse(const TiXmlNode *objectNode, Tmx::StringPool *stringPool);
 	
+		// Get the unique id of the object in the map, 0 if it has none.
+		int GetId() const { return id; }
+
 		// Get the name of the object.
-		const std::string &GetName() const { return name; }
+		const std::string &GetName() const { return *name; }
 		
 		// Get the type of the object.
-		const std::string &GetType() const { return type; }
+		const std::string &GetType() const { return *type; }
+
+		// Get the name and the type in the pool of the object.
+		const std::string *GetInternedName() const { return name; }
+		const std::string *GetInternedType() const { return type; }
 
 		// Get the left side of the object, in pixels.
 		int GetX() const { return x; }
@@ -85,8 +109,12 @@ namespace Tmx
 		const Tmx::PropertySet &GetProperties() const { return properties; }
 
 	private:
-		std::string name;
-		std::string type;
+		Tmx::Arena *arena;
+		Tmx::StringPool *own_pool;
+
+		int id;
+		const std::string *name;
+		const std::string *type;
 
 		int x;
 		int y;
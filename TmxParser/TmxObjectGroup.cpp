@@ -29,11 +29,26 @@
 
 #include "TmxObjectGroup.h"
 #include "TmxObject.h"
+#include "TmxArena.h"
+#include "TmxStringPool.h"
 
 namespace Tmx 
 {
 	ObjectGroup::ObjectGroup()
-		: name()
+		: arena(NULL)
+		, own_pool(NULL)
+		, id(0)
+		, name()
+		, width(0)
+		, height(0)
+		, zOrder(0)
+	{}
+
+	ObjectGroup::ObjectGroup(Arena *_arena)
+		: arena(_arena)
+		, own_pool(NULL)
+		, id(0)
+		, name()
 		, width(0)
 		, height(0)
 		, zOrder(0)
@@ -41,18 +56,40 @@ namespace Tmx
 
 	ObjectGroup::~ObjectGroup() 
 	{
-		for(std::size_t i = 0; i < objects.size(); i++)
+		// The objects made in an arena are destroyed by it.
+		if (!arena)
 		{
-			Object *obj = objects.at(i);
-			delete obj;
+			for(std::size_t i = 0; i < objects.size(); i++)
+			{
+				Object *obj = objects.at(i);
+				delete obj;
+			}
 		}
+
+		delete own_pool;
 	}
 
 	void ObjectGroup::Parse(const TiXmlNode *objectGroupNode) 
+	{
+		Parse(objectGroupNode, NULL);
+	}
+
+	void ObjectGroup::Parse(const TiXmlNode *objectGroupNode, StringPool *stringPool) 
 	{
 		const TiXmlElement *objectGroupElem = objectGroupNode->ToElement();
 
+		// A group parsed on its own keeps the strings in its own pool.
+		if (!stringPool)
+		{
+			if (!own_pool)
+			{
+				own_pool = new StringPool();
+			}
+			stringPool = own_pool;
+		}
+
 		// Read the object group attributes.
+		objectGroupElem->Attribute("id", &id);
 		name = objectGroupElem->Attribute("name");
 		
 		objectGroupElem->Attribute("width", &width);
@@ -63,7 +100,7 @@ namespace Tmx
 		const TiXmlNode *propertiesNode = objectGroupNode->FirstChild("properties");
 		if (propertiesNode) 
 		{
-			properties.Parse(propertiesNode);
+			properties.Parse(propertiesNode, stringPool);
 		}
 
 		// Iterate through all of the object elements.
@@ -71,8 +108,8 @@ namespace Tmx
 		while (objectNode) 
 		{
 			// Allocate a new object and parse it.
-			Object *object = new Object();
-			object->Parse(objectNode);
+			Object *object = arena ? arena->New< Object >(arena) : new Object();
+			object->Parse(objectNode, stringPool);
 			
 			// Add the object to the list.
 			objects.push_back(object);
@@ -36,6 +36,8 @@ class TiXmlNode;
 
 namespace Tmx 
 {
+	class Arena;
+	class StringPool;
 	class Object;
 	
 	//-------------------------------------------------------------------------
@@ -44,13 +46,26 @@ namespace Tmx
 	//-------------------------------------------------------------------------
 	class ObjectGroup 
 	{
+		friend class BinaryMap;
+
 	public:
 		ObjectGroup();
+
+		// Make an object group whose objects are made in an arena, they are
+		// left for the arena to destroy.
+		ObjectGroup(Tmx::Arena *_arena);
 		~ObjectGroup();
 
 		// Parse an objectgroup node.
 		void Parse(const TiXmlNode *objectGroupNode);
 
+		// Parse an objectgroup node, interning the strings of its objects
+		// in a pool which outlives the group.
+		void Parse(const TiXmlNode *objectGroupNode, Tmx::StringPool *stringPool);
+
+		// Get the unique id of the object group in the map, 0 if it has none.
+		int GetId() const { return id; }
+
 		// Get the name of the object group.
 		const std::string &GetName() const { return name; }
 
@@ -84,6 +99,10 @@ namespace Tmx
 		void SetZOrder( int z ) { zOrder = z; }
 
 	private:
+		Tmx::Arena *arena;
+		Tmx::StringPool *own_pool;
+
+		int id;
 		std::string name;
 		
 		int width;
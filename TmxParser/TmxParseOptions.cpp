@@ -0,0 +1,66 @@
+//-----------------------------------------------------------------------------
+// TmxParseOptions.cpp
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#include <algorithm>
+
+#include "TmxParseOptions.h"
+
+namespace Tmx
+{
+	ParseOptions::ParseOptions()
+	{}
+
+	void ParseOptions::Include(ParseElementType type, const std::string &name)
+	{
+		filters[type].included.push_back(name);
+	}
+
+	void ParseOptions::Exclude(ParseElementType type, const std::string &name)
+	{
+		filters[type].excluded.push_back(name);
+	}
+
+	void ParseOptions::Skip(ParseElementType type)
+	{
+		filters[type].skipped = true;
+	}
+
+	bool ParseOptions::IsParsed(ParseElementType type, const std::string &name) const
+	{
+		const Filter &filter = filters[type];
+		if (filter.skipped)
+		{
+			return false;
+		}
+		if (std::find(filter.excluded.begin(), filter.excluded.end(), name) != filter.excluded.end())
+		{
+			return false;
+		}
+		return filter.included.empty()
+			|| std::find(filter.included.begin(), filter.included.end(), name) != filter.included.end();
+	}
+};
@@ -0,0 +1,90 @@
+//-----------------------------------------------------------------------------
+// TmxParseOptions.h
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Tmx
+{
+	//-------------------------------------------------------------------------
+	// The kinds of elements which can be left out of the parsing.
+	//-------------------------------------------------------------------------
+	enum ParseElementType
+	{
+		// Tile layers, by their name.
+		TMX_PARSE_LAYERS,
+
+		// Image layers, by their name.
+		TMX_PARSE_IMAGE_LAYERS,
+
+		// Object groups, by their name.
+		TMX_PARSE_OBJECT_GROUPS,
+
+		// The properties of the tiles of tilesets, by the tileset name.
+		TMX_PARSE_TILE_PROPERTIES
+	};
+
+	//-------------------------------------------------------------------------
+	// Options telling which elements of a map are parsed. An element is
+	// parsed unless its kind is skipped, its name is excluded, or names of
+	// its kind are included and its name is not one of them.
+	// The elements left out are stepped over by the parser without being
+	// built, but still count in the zorder of the others.
+	//-------------------------------------------------------------------------
+	class ParseOptions
+	{
+	public:
+		ParseOptions();
+
+		// Parse the elements of a kind with this name only, along with the
+		// other names included.
+		void Include(Tmx::ParseElementType type, const std::string &name);
+
+		// Do not parse the elements of a kind with this name.
+		void Exclude(Tmx::ParseElementType type, const std::string &name);
+
+		// Do not parse any element of a kind.
+		void Skip(Tmx::ParseElementType type);
+
+		// Get whether an element of a kind with a name is parsed.
+		bool IsParsed(Tmx::ParseElementType type, const std::string &name) const;
+
+	private:
+		struct Filter
+		{
+			Filter() : skipped(false), included(), excluded() {}
+
+			bool skipped;
+			std::vector< std::string > included;
+			std::vector< std::string > excluded;
+		};
+
+		Filter filters[TMX_PARSE_TILE_PROPERTIES + 1];
+	};
+};
@@ -40,6 +40,8 @@ namespace Tmx
 	//-------------------------------------------------------------------------
 	class Polygon
 	{
+		friend class BinaryMap;
+
 	public:
 		Polygon();
 
@@ -40,6 +40,8 @@ namespace Tmx
 	//-------------------------------------------------------------------------
 	class Polyline
 	{
+		friend class BinaryMap;
+
 	public:
 		Polyline();
 
@@ -0,0 +1,66 @@
+//-----------------------------------------------------------------------------
+// TmxProperty.cpp
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <string.h>
+
+#include "TmxProperty.h"
+#include "TmxStringPool.h"
+
+using std::string;
+
+namespace Tmx
+{
+	Property::Property()
+		: name(StringPool::GetEmpty())
+		, value(StringPool::GetEmpty())
+		, type(TMX_PROPERTY_STRING)
+		, int_value(0)
+		, float_value(0.0f)
+		, bool_value(false)
+	{}
+
+	Property::Property(const string *_name, const string *_value, PropertyType _type)
+		: name(_name)
+		, value(_value)
+		, type(_type)
+		, int_value(atoi(_value->c_str()))
+		, float_value((float)atof(_value->c_str()))
+		, bool_value(*_value == "true" || atof(_value->c_str()) != 0.0)
+	{}
+
+	PropertyType Property::ParseType(const char *typeStr)
+	{
+		if (typeStr)
+		{
+			if (strcmp(typeStr, "int") == 0) return TMX_PROPERTY_INT;
+			if (strcmp(typeStr, "float") == 0) return TMX_PROPERTY_FLOAT;
+			if (strcmp(typeStr, "bool") == 0) return TMX_PROPERTY_BOOL;
+		}
+		return TMX_PROPERTY_STRING;
+	}
+};
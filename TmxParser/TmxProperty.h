@@ -0,0 +1,99 @@
+//-----------------------------------------------------------------------------
+// TmxProperty.h
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <string>
+
+namespace Tmx
+{
+	//-------------------------------------------------------------------------
+	// The types of the properties, from their type attribute.
+	//-------------------------------------------------------------------------
+	enum PropertyType
+	{
+		// A string, also the type of the properties without a type.
+		TMX_PROPERTY_STRING,
+
+		// An integer.
+		TMX_PROPERTY_INT,
+
+		// A float.
+		TMX_PROPERTY_FLOAT,
+
+		// A boolean, "true" or "false".
+		TMX_PROPERTY_BOOL
+	};
+
+	//-------------------------------------------------------------------------
+	// A single property, its value is converted to every type once when it
+	// is made, whatever its declared type. The name and value are strings
+	// of a StringPool, which has to outlive the property.
+	//-------------------------------------------------------------------------
+	class Property
+	{
+	public:
+		Property();
+		Property(const std::string *_name, const std::string *_value, Tmx::PropertyType _type);
+
+		// Get the type of a property from its type attribute.
+		static Tmx::PropertyType ParseType(const char *typeStr);
+
+		// Get the name of the property.
+		const std::string &GetName() const { return *name; }
+
+		// Get the value of the property as it is written.
+		const std::string &GetValue() const { return *value; }
+
+		// Get the name and the value in their pool, they are equal to the
+		// strings of the same pool exactly when their pointers are.
+		const std::string *GetInternedName() const { return name; }
+		const std::string *GetInternedValue() const { return value; }
+
+		// Get the declared type of the property.
+		Tmx::PropertyType GetType() const { return type; }
+
+		// Get the value of the property as an integer, 0 if it is not one.
+		int GetIntValue() const { return int_value; }
+
+		// Get the value of the property as a float, 0 if it is not one.
+		float GetFloatValue() const { return float_value; }
+
+		// Get the value of the property as a boolean, true for "true" and
+		// for numbers other than 0.
+		bool GetBoolValue() const { return bool_value; }
+
+	private:
+		const std::string *name;
+		const std::string *value;
+		Tmx::PropertyType type;
+
+		int int_value;
+		float float_value;
+		bool bool_value;
+	};
+};
@@ -26,69 +26,197 @@
 // Author: Tamir Atias
 //-----------------------------------------------------------------------------
 #include <tinyxml.h>
+#include <string.h>
+#include <algorithm>
 
 #include "TmxPropertySet.h"
+#include "TmxStringPool.h"
 
 using std::string;
 using std::map;
+using std::vector;
 
 namespace Tmx 
 {
+	// Orders the properties by their name.
+	static bool PropertyNameLess(const Property &property, const char *name)
+	{
+		return strcmp(property.GetName().c_str(), name) < 0;
+	}
 		
-	PropertySet::PropertySet() : properties()  
+	PropertySet::PropertySet() 
+		: properties()  
+		, pool(NULL)
+		, own_pool(NULL)
 	{}
 
+	PropertySet::PropertySet(const PropertySet &_propertySet) 
+		: properties()  
+		, pool(NULL)
+		, own_pool(NULL)
+	{
+		*this = _propertySet;
+	}
+
+	PropertySet &PropertySet::operator=(const PropertySet &_propertySet) 
+	{
+		// The strings are interned again, the copy may outlive the pool
+		// of the original.
+		if (this != &_propertySet)
+		{
+			properties.clear();
+			for (unsigned int i = 0; i < _propertySet.properties.size(); ++i)
+			{
+				const Property &property = _propertySet.properties[i];
+				Add(property.GetName(), property.GetValue(), property.GetType());
+			}
+		}
+		return *this;
+	}
+
 	PropertySet::~PropertySet()
 	{
 		properties.clear();
+		delete own_pool;
 	}
 
 	void PropertySet::Parse(const TiXmlNode *propertiesNode) 
 	{
+		Parse(propertiesNode, NULL);
+	}
+
+	void PropertySet::Parse(const TiXmlNode *propertiesNode, StringPool *stringPool) 
+	{
+		SetStringPool(stringPool);
+
 		// Iterate through all of the property nodes.
 		const TiXmlNode *propertyNode = propertiesNode->FirstChild("property");
-		string propertyName;
-		string propertyValue;
 
 		while (propertyNode) 
 		{
 			const TiXmlElement* propertyElem = propertyNode->ToElement();
 
-			// Read the attributes of the property and add it to the map
-			propertyName = string(propertyElem->Attribute("name"));
-			propertyValue = string(propertyElem->Attribute("value"));
-			properties[propertyName] = propertyValue;
+			// Read the attributes of the property and add it to the list,
+			// multiline values are written as the text of the element.
+			const char *propertyName = propertyElem->Attribute("name");
+			const char *propertyValue = propertyElem->Attribute("value");
+			if (!propertyValue)
+			{
+				propertyValue = propertyElem->GetText();
+			}
+			Add(propertyName ? propertyName : "", propertyValue ? propertyValue : "", 
+				Property::ParseType(propertyElem->Attribute("type")));
 			
 			propertyNode = propertiesNode->IterateChildren(
 				"property", propertyNode);
 		}
 	}
 
+	const Property *PropertySet::GetProperty(const char *name) const 
+	{
+		vector< Property >::const_iterator iter = std::lower_bound(properties.begin(), properties.end(), name, PropertyNameLess);
+		if (iter == properties.end() || iter->GetName() != name)
+			return NULL;
+
+		return &*iter;
+	}
+
+	const Property *PropertySet::GetProperty(const string &name) const 
+	{
+		return GetProperty(name.c_str());
+	}
+
+	const Property *PropertySet::GetInternedProperty(const string *name) const 
+	{
+		// The sets are small, a scan comparing pointers beats a search
+		// comparing strings.
+		for (unsigned int i = 0; i < properties.size(); ++i)
+		{
+			if (properties[i].GetInternedName() == name)
+				return &properties[i];
+		}
+
+		return NULL;
+	}
+
 	string PropertySet::GetLiteralProperty(const string &name) const 
 	{
-		// Find the property in the map.
-		map< string, string >::const_iterator iter = properties.find(name);
+		// Find the property in the list.
+		const Property *property = GetProperty(name);
 
-		if (iter == properties.end())
+		if (!property)
 			return std::string("No such property!");
 
-		return iter->second;
+		return property->GetValue();
 	}
 
 	int PropertySet::GetNumericProperty(const string &name) const 
 	{
-		return atoi(GetLiteralProperty(name).c_str());
+		const Property *property = GetProperty(name);
+		return property ? property->GetIntValue() : 0;
 	}
 
 	float PropertySet::GetFloatProperty(const string &name) const 
 	{
-		return float(atof(GetLiteralProperty(name).c_str()));
+		const Property *property = GetProperty(name);
+		return property ? property->GetFloatValue() : 0.0f;
+	}
+
+	bool PropertySet::GetBoolProperty(const string &name) const 
+	{
+		const Property *property = GetProperty(name);
+		return property ? property->GetBoolValue() : false;
 	}
 
 	bool PropertySet::HasProperty( const string& name ) const
 	{
 		if( properties.empty() ) return false;
-		return ( properties.find(name) != properties.end() );
+		return GetProperty(name) != NULL;
+	}
+
+	map< string, string > PropertySet::GetList() const
+	{
+		map< string, string > list;
+		for (unsigned int i = 0; i < properties.size(); ++i)
+		{
+			list[properties[i].GetName()] = properties[i].GetValue();
+		}
+		return list;
+	}
+
+	void PropertySet::SetStringPool(StringPool *stringPool)
+	{
+		if (!pool)
+		{
+			pool = stringPool;
+		}
+	}
+
+	void PropertySet::Add(const string &name, const string &value, PropertyType type)
+	{
+		if (!pool)
+		{
+			own_pool = new StringPool();
+			pool = own_pool;
+		}
+		const Property property(pool->Intern(name), pool->Intern(value), type);
+
+		// Properties are mostly written sorted by name.
+		if (properties.empty() || properties.back().GetName() < name)
+		{
+			properties.push_back(property);
+			return;
+		}
+
+		vector< Property >::iterator iter = std::lower_bound(properties.begin(), properties.end(), name.c_str(), PropertyNameLess);
+		if (iter != properties.end() && iter->GetName() == name)
+		{
+			*iter = property;
+		}
+		else
+		{
+			properties.insert(iter, property);
+		}
 	}
 
 };
@@ -29,29 +29,58 @@
 
 #include <map>
 #include <string>
+#include <vector>
+
+#include "TmxProperty.h"
 
 class TiXmlNode;
 
 namespace Tmx 
 {
+	class StringPool;
+
 	//-----------------------------------------------------------------------------
-	// This class contains a map of properties.
+	// This class contains a list of properties, sorted by their name.
+	// The lookups by name do not allocate, and the values are converted to
+	// numbers once when the properties are parsed.
+	// The names and values are interned in the string pool of the map, or
+	// in a pool of the set's own when it is parsed on its own.
 	//-----------------------------------------------------------------------------
 	class PropertySet 
 	{
+		friend class BinaryMap;
+
 	public:
 		PropertySet();
+		PropertySet(const PropertySet &_propertySet);
+		PropertySet &operator=(const PropertySet &_propertySet);
 		~PropertySet();
 
 		// Parse a node containing all the property nodes.
 		void Parse(const TiXmlNode *propertiesNode);
+
+		// Parse a node containing all the property nodes, interning the
+		// names and values in a pool which outlives the set.
+		void Parse(const TiXmlNode *propertiesNode, Tmx::StringPool *stringPool);
 	
+		// Get a property by its name, NULL if there is none.
+		const Tmx::Property *GetProperty(const char *name) const;
+		const Tmx::Property *GetProperty(const std::string &name) const;
+
+		// Get a property by its name interned in the pool of the set (see
+		// StringPool::Find()), comparing pointers only. NULL if there is none.
+		const Tmx::Property *GetInternedProperty(const std::string *name) const;
+
 		// Get a numeric property (integer).
 		int GetNumericProperty(const std::string &name) const;
 		// Get a numeric property (float).
 		float GetFloatProperty(const std::string &name) const;
+		// Get a boolean property.
+		bool GetBoolProperty(const std::string &name) const;
 
 		// Get a literal property (string).
+		// Returns "No such property!" for a missing property, use
+		// GetProperty() to tell those apart without a copy.
 		std::string GetLiteralProperty(const std::string &name) const;
 
 		// Returns the amount of properties.
@@ -59,15 +88,28 @@ namespace Tmx
 
 		bool HasProperty( const std::string& name ) const;
 
-		// Returns the STL map of the properties.
-		std::map< std::string, std::string > GetList() const 
-		{ return properties; }
+		// Returns the properties, sorted by their name.
+		const std::vector< Tmx::Property > &GetPropertyList() const { return properties; }
+
+		// Returns a copy of the properties in an STL map.
+		std::map< std::string, std::string > GetList() const;
 
 		// Returns whether there are no properties.
 		bool Empty() const { return properties.empty(); }
 
+		// Get the pool of the names and values, NULL before any is added.
+		const Tmx::StringPool *GetStringPool() const { return pool; }
+
 	private:
-		std::map< std::string, std::string > properties;
+		// Use a pool for the names and values, unless there is one already.
+		void SetStringPool(Tmx::StringPool *stringPool);
+
+		// Add a property, or replace the one of the same name.
+		void Add(const std::string &name, const std::string &value, Tmx::PropertyType type);
+
+		std::vector< Tmx::Property > properties;
 
+		Tmx::StringPool *pool;
+		Tmx::StringPool *own_pool;
 	};
 };
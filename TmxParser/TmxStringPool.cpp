@@ -0,0 +1,70 @@
+//-----------------------------------------------------------------------------
+// TmxStringPool.cpp
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#include "TmxStringPool.h"
+
+using std::string;
+
+namespace Tmx
+{
+	StringPool::StringPool()
+		: strings()
+	{}
+
+	StringPool::~StringPool()
+	{}
+
+	const string *StringPool::Intern(const string &text)
+	{
+		// Every pool has the same empty string, so it equals GetEmpty().
+		if (text.empty())
+		{
+			return GetEmpty();
+		}
+		return &*strings.insert(text).first;
+	}
+
+	const string *StringPool::Find(const string &text) const
+	{
+		if (text.empty())
+		{
+			return GetEmpty();
+		}
+		std::set< string >::const_iterator iter = strings.find(text);
+		if (iter == strings.end())
+		{
+			return NULL;
+		}
+		return &*iter;
+	}
+
+	const string *StringPool::GetEmpty()
+	{
+		static const string empty;
+		return &empty;
+	}
+};
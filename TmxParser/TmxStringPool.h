@@ -0,0 +1,70 @@
+//-----------------------------------------------------------------------------
+// TmxStringPool.h
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <set>
+#include <string>
+
+namespace Tmx
+{
+	//-------------------------------------------------------------------------
+	// Keeps a single copy of every string added to it. A map interns the
+	// names and values of its properties and the names and types of its
+	// objects in a pool of its own, so that they are stored once however
+	// many times they are used, and are equal exactly when their pointers
+	// are. The strings stay valid as long as the pool.
+	//-------------------------------------------------------------------------
+	class StringPool
+	{
+	private:
+		// Prevent copy constructor.
+		StringPool(const StringPool &_stringPool);
+		StringPool &operator=(const StringPool &_stringPool);
+
+	public:
+		StringPool();
+		~StringPool();
+
+		// Get the copy of a string in the pool, adding it if there is none.
+		// The empty string is always GetEmpty().
+		const std::string *Intern(const std::string &text);
+
+		// Get the copy of a string in the pool, NULL if it was never added,
+		// in which case no name or value interned in the pool is that string.
+		const std::string *Find(const std::string &text) const;
+
+		// Get the amount of strings in the pool, not counting the empty one.
+		int GetSize() const { return strings.size(); }
+
+		// Get an empty string, the same for every pool.
+		static const std::string *GetEmpty();
+
+	private:
+		std::set< std::string > strings;
+	};
+};
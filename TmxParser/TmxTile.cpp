@@ -34,13 +34,18 @@ namespace Tmx
     Tile::Tile(int id) : id(id)
     {}
 
-	Tile::Tile() : properties()
+	Tile::Tile() : id(0), properties()
 	{}
 
 	Tile::~Tile() 
 	{}
 
 	void Tile::Parse(const TiXmlNode *tileNode) 
+	{
+		Parse(tileNode, NULL);
+	}
+
+	void Tile::Parse(const TiXmlNode *tileNode, StringPool *stringPool) 
 	{
 		const TiXmlElement *tileElem = tileNode->ToElement();
 
@@ -52,7 +57,7 @@ namespace Tmx
 		
 		if (propertiesNode) 
 		{
-			properties.Parse(propertiesNode);
+			properties.Parse(propertiesNode, stringPool);
 		}
 	}
 };
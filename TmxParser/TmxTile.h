@@ -40,6 +40,8 @@ namespace Tmx
 	//-------------------------------------------------------------------------
 	class Tile 
 	{
+		friend class BinaryMap;
+
 	public:
         Tile(int id);
 		Tile();
@@ -47,6 +49,10 @@ namespace Tmx
 	
 		// Parse a tile node.
 		void Parse(const TiXmlNode *tileNode);
+
+		// Parse a tile node, interning the strings of the properties in a
+		// pool which outlives the tile.
+		void Parse(const TiXmlNode *tileNode, Tmx::StringPool *stringPool);
 		
 		// Get the Id. (relative to the tilset)
 		int GetId() const { return id; }
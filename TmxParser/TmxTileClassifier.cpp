@@ -0,0 +1,438 @@
+//-----------------------------------------------------------------------------
+// TmxTileClassifier.cpp
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <ctype.h>
+#include <algorithm>
+
+#include "TmxTileClassifier.h"
+#include "TmxMap.h"
+#include "TmxTileset.h"
+#include "TmxTile.h"
+#include "TmxPropertySet.h"
+
+using std::string;
+using std::vector;
+
+namespace Tmx
+{
+	//-------------------------------------------------------------------------
+	// Recursive descent compiler turning an expression into a program in
+	// postfix order.
+	//-------------------------------------------------------------------------
+	class TileClassifier::Compiler
+	{
+	public:
+		Compiler(const string &_text, vector< Instruction > &_program)
+			: text(_text)
+			, program(_program)
+			, pos(0)
+			, token(TOKEN_END)
+			, quoted(false)
+		{}
+
+		bool Compile(string &error)
+		{
+			if (!Next() || !ParseOr())
+			{
+				error = this->error;
+				return false;
+			}
+			if (token != TOKEN_END)
+			{
+				error = "Unexpected '" + word + "' in expression.";
+				return false;
+			}
+			return true;
+		}
+
+	private:
+		enum TokenType
+		{
+			TOKEN_END,
+			TOKEN_WORD,
+			TOKEN_AND,
+			TOKEN_OR,
+			TOKEN_NOT,
+			TOKEN_OPEN,
+			TOKEN_CLOSE,
+			TOKEN_COMMA,
+			TOKEN_COMPARE
+		};
+
+		static bool IsWordChar(char c)
+		{
+			return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+				|| (c >= '0' && c <= '9') || c == '_' || c == '-' || c == '.';
+		}
+
+		// Read the next token into token/word.
+		bool Next()
+		{
+			while (pos < text.size() && isspace((unsigned char)text[pos]))
+			{
+				++pos;
+			}
+
+			quoted = false;
+			word.clear();
+			if (pos >= text.size())
+			{
+				token = TOKEN_END;
+				return true;
+			}
+
+			const char c = text[pos];
+			const char n = pos + 1 < text.size() ? text[pos + 1] : 0;
+			if (c == '"' || c == '\'')
+			{
+				size_t end = text.find(c, pos + 1);
+				if (end == string::npos)
+				{
+					error = "Unterminated string in expression.";
+					return false;
+				}
+				word = text.substr(pos + 1, end - pos - 1);
+				quoted = true;
+				token = TOKEN_WORD;
+				pos = end + 1;
+				return true;
+			}
+			if (IsWordChar(c))
+			{
+				size_t end = pos;
+				while (end < text.size() && IsWordChar(text[end]))
+				{
+					++end;
+				}
+				word = text.substr(pos, end - pos);
+				token = TOKEN_WORD;
+				pos = end;
+				return true;
+			}
+
+			size_t length = 1;
+			if (c == '&' && n == '&') { token = TOKEN_AND; length = 2; }
+			else if (c == '|' && n == '|') { token = TOKEN_OR; length = 2; }
+			else if ((c == '=' || c == '!' || c == '<' || c == '>') && n == '=') { token = TOKEN_COMPARE; length = 2; }
+			else if (c == '=' || c == '<' || c == '>') token = TOKEN_COMPARE;
+			else if (c == '!') token = TOKEN_NOT;
+			else if (c == '(') token = TOKEN_OPEN;
+			else if (c == ')') token = TOKEN_CLOSE;
+			else if (c == ',') token = TOKEN_COMMA;
+			else
+			{
+				error = string("Unexpected character '") + c + "' in expression.";
+				return false;
+			}
+			word = text.substr(pos, length);
+			pos += length;
+			return true;
+		}
+
+		bool Expect(TokenType type, const char *what)
+		{
+			if (token != type)
+			{
+				error = string("Expected ") + what + " in expression.";
+				return false;
+			}
+			return Next();
+		}
+
+		void Emit(OpCode op, const string &name = string())
+		{
+			Instruction instruction;
+			instruction.op = op;
+			instruction.name = name;
+			program.push_back(instruction);
+		}
+
+		// or := and ('||' and)*
+		bool ParseOr()
+		{
+			if (!ParseAnd()) return false;
+			while (token == TOKEN_OR)
+			{
+				if (!Next() || !ParseAnd()) return false;
+				Emit(OP_OR);
+			}
+			return true;
+		}
+
+		// and := unary ('&&' unary)*
+		bool ParseAnd()
+		{
+			if (!ParseUnary()) return false;
+			while (token == TOKEN_AND)
+			{
+				if (!Next() || !ParseUnary()) return false;
+				Emit(OP_AND);
+			}
+			return true;
+		}
+
+		// unary := '!' unary | '(' or ')' | name [comparison]
+		bool ParseUnary()
+		{
+			if (token == TOKEN_NOT)
+			{
+				if (!Next() || !ParseUnary()) return false;
+				Emit(OP_NOT);
+				return true;
+			}
+			if (token == TOKEN_OPEN)
+			{
+				return Next() && ParseOr() && Expect(TOKEN_CLOSE, "')'");
+			}
+			if (token != TOKEN_WORD)
+			{
+				error = "Expected a property name in expression.";
+				return false;
+			}
+
+			const string name = word;
+			if (!Next()) return false;
+
+			// comparison := ('='|'=='|'!='|'<'|'<='|'>'|'>=') value
+			//             | 'in' '(' value (',' value)* ')'
+			if (token == TOKEN_COMPARE)
+			{
+				OpCode op;
+				if (word == "=" || word == "==") op = OP_EQUAL;
+				else if (word == "!=") op = OP_NOT_EQUAL;
+				else if (word == "<") op = OP_LESS;
+				else if (word == "<=") op = OP_LESS_EQUAL;
+				else if (word == ">") op = OP_GREATER;
+				else op = OP_GREATER_EQUAL;
+
+				if (!Next()) return false;
+				if (token != TOKEN_WORD)
+				{
+					error = "Expected a value after '" + name + "' in expression.";
+					return false;
+				}
+				Emit(op, name);
+				program.back().values.push_back(word);
+				return Next();
+			}
+			if (token == TOKEN_WORD && !quoted && word == "in")
+			{
+				if (!Next() || !Expect(TOKEN_OPEN, "'(' after 'in'")) return false;
+				Emit(OP_IN, name);
+				while (true)
+				{
+					if (token != TOKEN_WORD)
+					{
+						error = "Expected a value in the list of '" + name + "'.";
+						return false;
+					}
+					program.back().values.push_back(word);
+					if (!Next()) return false;
+					if (token == TOKEN_CLOSE) break;
+					if (!Expect(TOKEN_COMMA, "',' or ')'")) return false;
+				}
+				return Next();
+			}
+
+			Emit(OP_HAS, name);
+			return true;
+		}
+
+		const string &text;
+		vector< Instruction > &program;
+		size_t pos;
+
+		TokenType token;
+		string word;
+		bool quoted;
+
+		string error;
+	};
+
+	TileClassifier::TileClassifier()
+		: classes()
+		, table()
+		, has_error(false)
+		, error_text()
+	{}
+
+	TileClassifier::~TileClassifier()
+	{}
+
+	int TileClassifier::AddClass(const string &name, const string &expression)
+	{
+		if (classes.size() >= 255)
+		{
+			has_error = true;
+			error_text = "Too many classes.";
+			return 0;
+		}
+
+		Class tileClass;
+		tileClass.name = name;
+
+		Compiler compiler(expression, tileClass.program);
+		if (!compiler.Compile(error_text))
+		{
+			has_error = true;
+			error_text = name + ": " + error_text;
+			return 0;
+		}
+		classes.push_back(tileClass);
+		return classes.size();
+	}
+
+	void TileClassifier::Compile(const Map *map)
+	{
+		table.clear();
+
+		// Tiles without properties all share the same class.
+		const PropertySet noProperties;
+		const unsigned char defaultClass = (unsigned char)Classify(noProperties);
+
+		const vector< Tileset* > &tilesets = map->GetTilesets();
+		for (unsigned int i = 0; i < tilesets.size(); ++i)
+		{
+			const Tileset *tileset = tilesets[i];
+			const vector< Tile* > &tiles = tileset->GetTiles();
+
+			// Only the tiles with properties are listed, the others of the
+			// image get the default class.
+			const unsigned firstGid = tileset->GetFirstGid();
+			const unsigned numTiles = tileset->GetNumTiles();
+			if (table.size() < firstGid + numTiles)
+			{
+				table.resize(firstGid + numTiles, 0);
+			}
+			std::fill(table.begin() + firstGid, table.begin() + firstGid + numTiles, defaultClass);
+
+			for (unsigned int t = 0; t < tiles.size(); ++t)
+			{
+				const Tile *tile = tiles[t];
+				if (tile->GetProperties().Empty() || tile->GetId() < 0)
+				{
+					continue;
+				}
+
+				const unsigned gid = firstGid + tile->GetId();
+				if (table.size() <= gid)
+				{
+					table.resize(gid + 1, 0);
+				}
+				table[gid] = (unsigned char)Classify(tile->GetProperties());
+			}
+		}
+
+		// The gid 0 is an empty cell.
+		if (!table.empty())
+		{
+			table[0] = 0;
+		}
+	}
+
+	int TileClassifier::Classify(const PropertySet &properties) const
+	{
+		for (unsigned int i = 0; i < classes.size(); ++i)
+		{
+			if (Evaluate(classes[i], properties))
+			{
+				return i + 1;
+			}
+		}
+		return 0;
+	}
+
+	bool TileClassifier::Evaluate(const Class &tileClass, const PropertySet &properties) const
+	{
+		vector< bool > stack;
+		stack.reserve(tileClass.program.size());
+
+		for (unsigned int i = 0; i < tileClass.program.size(); ++i)
+		{
+			const Instruction &instruction = tileClass.program[i];
+			bool result = false;
+
+			switch (instruction.op)
+			{
+			case OP_NOT:
+				stack.back() = !stack.back();
+				continue;
+
+			case OP_AND:
+			case OP_OR:
+				{
+					const bool rhs = stack.back();
+					stack.pop_back();
+					if (instruction.op == OP_AND)
+						stack.back() = stack.back() && rhs;
+					else
+						stack.back() = stack.back() || rhs;
+				}
+				continue;
+
+			case OP_HAS:
+				result = properties.GetProperty(instruction.name) != NULL;
+				break;
+
+			default:
+				if (const Property *property = properties.GetProperty(instruction.name))
+				{
+					const string &value = property->GetValue();
+					const string &operand = instruction.values[0];
+					switch (instruction.op)
+					{
+					case OP_EQUAL: result = value == operand; break;
+					case OP_NOT_EQUAL: result = value != operand; break;
+					case OP_LESS: result = atof(value.c_str()) < atof(operand.c_str()); break;
+					case OP_LESS_EQUAL: result = atof(value.c_str()) <= atof(operand.c_str()); break;
+					case OP_GREATER: result = atof(value.c_str()) > atof(operand.c_str()); break;
+					case OP_GREATER_EQUAL: result = atof(value.c_str()) >= atof(operand.c_str()); break;
+					case OP_IN:
+						for (unsigned int v = 0; v < instruction.values.size() && !result; ++v)
+						{
+							result = value == instruction.values[v];
+						}
+						break;
+					default:
+						break;
+					}
+				}
+				else
+				{
+					// A missing property is different from anything.
+					result = instruction.op == OP_NOT_EQUAL;
+				}
+				break;
+			}
+
+			stack.push_back(result);
+		}
+
+		return stack.back();
+	}
+};
@@ -0,0 +1,137 @@
+//-----------------------------------------------------------------------------
+// TmxTileClassifier.h
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "TmxMapTile.h"
+
+namespace Tmx
+{
+	class Map;
+	class PropertySet;
+
+	//-------------------------------------------------------------------------
+	// Sorts the tiles of a map into classes selected by predicates on their
+	// properties, for example:
+	//   wall
+	//   solid && !breakable
+	//   material in (stone, metal)
+	//   damage >= 10 || (kind == "lava" && !cooled)
+	// A bare name tests whether a property exists, '=' or '==' and '!='
+	// compare the literal value, '<', '<=', '>' and '>=' compare the numeric
+	// value and 'in' tests the value against a list. Names and values are
+	// words made of letters, digits, '_', '-' and '.' or quoted strings.
+	//
+	// The predicates are compiled once against the property sets of every
+	// tile of every tileset into a table from gid to class, so classifying
+	// a tile is a single table load.
+	// A tile belongs to the first class it matches, class 0 means none.
+	//-------------------------------------------------------------------------
+	class TileClassifier
+	{
+	public:
+		TileClassifier();
+		~TileClassifier();
+
+		// Add a class selected by a predicate expression.
+		// Returns the id of the class, starting at 1, or 0 if the expression
+		// is invalid, in which case the error text tells why.
+		int AddClass(const std::string &name, const std::string &expression);
+
+		// Build the gid to class table from the tilesets of a map.
+		void Compile(const Tmx::Map *map);
+
+		// Get the class of a gid, flip flags are ignored.
+		unsigned char GetClass(unsigned gid) const
+		{
+			gid &= ~(FlippedHorizontallyFlag | FlippedVerticallyFlag | FlippedDiagonallyFlag);
+			return gid < table.size() ? table[gid] : 0;
+		}
+
+		// Get the class of any property set (of an object for example) by
+		// evaluating the predicates.
+		int Classify(const Tmx::PropertySet &properties) const;
+
+		// Get the gid to class table, valid after Compile().
+		const std::vector< unsigned char > &GetTable() const { return table; }
+
+		// Get the amount of classes.
+		int GetNumClasses() const { return classes.size(); }
+
+		// Get the name of a class by id.
+		const std::string &GetName(int classId) const { return classes.at(classId - 1).name; }
+
+		// Get whether an expression could not be compiled.
+		bool HasError() const { return has_error; }
+
+		// Get an error string containing the error in text format.
+		const std::string &GetErrorText() const { return error_text; }
+
+	private:
+		// Instructions of a compiled predicate, evaluated on a stack.
+		enum OpCode
+		{
+			OP_HAS,
+			OP_EQUAL,
+			OP_NOT_EQUAL,
+			OP_LESS,
+			OP_LESS_EQUAL,
+			OP_GREATER,
+			OP_GREATER_EQUAL,
+			OP_IN,
+			OP_NOT,
+			OP_AND,
+			OP_OR
+		};
+
+		struct Instruction
+		{
+			OpCode op;
+			std::string name;
+			std::vector< std::string > values;
+		};
+
+		struct Class
+		{
+			std::string name;
+			std::vector< Instruction > program;
+		};
+
+		class Compiler;
+
+		bool Evaluate(const Class &tileClass, const Tmx::PropertySet &properties) const;
+
+		std::vector< Class > classes;
+		std::vector< unsigned char > table;
+
+		bool has_error;
+		std::string error_text;
+	};
+};
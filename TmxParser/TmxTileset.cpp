@@ -26,8 +26,11 @@
 // Author: Tamir Atias
 //-----------------------------------------------------------------------------
 #include <tinyxml.h>
+#include <algorithm>
 
 #include "TmxTileset.h"
+#include "TmxArena.h"
+#include "TmxStringPool.h"
 #include "TmxImage.h"
 #include "TmxTile.h"
 
@@ -36,20 +39,57 @@ using std::string;
 
 namespace Tmx 
 {
+	// Orders the tiles by their id.
+	static bool TileIdLess(const Tile *tile, int id)
+	{
+		return tile->GetId() < id;
+	}
+
+	// The most ids the table of tiles covers, 512KB of pointers at most
+	// whatever the ids in the file.
+	static const int MaxTableSize = 1 << 16;
+
 	Tileset::Tileset() 
-		: first_gid(0)
+		: arena(NULL)
+		, own_pool(NULL)
+		, first_gid(0)
 		, name()
 		, tile_width(0)
 		, tile_height(0)
 		, margin(0)
 		, spacing(0)
+		, tile_count(0)
 		, image(NULL)
 		, tiles()
+		, tile_table()
+	{
+	}
+
+	Tileset::Tileset(Arena *_arena) 
+		: arena(_arena)
+		, own_pool(NULL)
+		, first_gid(0)
+		, name()
+		, tile_width(0)
+		, tile_height(0)
+		, margin(0)
+		, spacing(0)
+		, tile_count(0)
+		, image(NULL)
+		, tiles()
+		, tile_table()
 	{
 	}
 
 	Tileset::~Tileset() 
 	{
+		// The image and the tiles made in an arena are destroyed by it.
+		if (arena)
+		{
+			delete own_pool;
+			return;
+		}
+
 		// Delete the image from memory if allocated.
 		if (image) 
 		{
@@ -69,18 +109,41 @@ namespace Tmx
 				tile = NULL;
 			}
 		}
+
+		delete own_pool;
 	}
 
 	void Tileset::Parse(const TiXmlNode *tilesetNode) 
+	{
+		Parse(tilesetNode, true);
+	}
+
+	void Tileset::Parse(const TiXmlNode *tilesetNode, bool parseTiles) 
+	{
+		Parse(tilesetNode, parseTiles, NULL);
+	}
+
+	void Tileset::Parse(const TiXmlNode *tilesetNode, bool parseTiles, StringPool *stringPool) 
 	{
 		const TiXmlElement *tilesetElem = tilesetNode->ToElement();
 
+		// A tileset parsed on its own keeps the strings in its own pool.
+		if (!stringPool)
+		{
+			if (!own_pool)
+			{
+				own_pool = new StringPool();
+			}
+			stringPool = own_pool;
+		}
+
 		// Read all the attributes into local variables.
 		tilesetElem->Attribute("firstgid", &first_gid);
 		tilesetElem->Attribute("tilewidth", &tile_width);
 		tilesetElem->Attribute("tileheight", &tile_height);
 		tilesetElem->Attribute("margin", &margin);
 		tilesetElem->Attribute("spacing", &spacing);
+		tilesetElem->Attribute("tilecount", &tile_count);
 
 		name = tilesetElem->Attribute("name");
 
@@ -89,32 +152,31 @@ namespace Tmx
 		
 		if (imageNode) 
 		{
-			image = new Image();
+			image = arena ? arena->New< Image >() : new Image();
 			image->Parse(imageNode);
 		}
 
-        // Populate the tile list
-        int tileCount = (image->GetWidth() / tile_width) * (image->GetHeight() / tile_height);
-
-        int tId = tiles.size();
-        while (tId < tileCount)
+        // Count the tiles of the image, unless the tileset tells.
+        if (tile_count <= 0 && image && tile_width > 0 && tile_height > 0)
         {
-            Tile* tile = new Tile(tId);
-            tiles.push_back(tile);
-            tId++;
+            tile_count = (image->GetWidth() / tile_width) * (image->GetHeight() / tile_height);
         }
 
-
-        // Iterate through all of the tile elements and parse each.
-        const TiXmlNode *tileNode = tilesetNode->FirstChild("tile");
+        // Iterate through all of the tile elements and parse each, only
+        // these tiles are kept.
+        const TiXmlNode *tileNode = parseTiles ? tilesetNode->FirstChild("tile") : NULL;
         while (tileNode)
 		{
-            // Parse it to get the tile id.
-            Tile tile;
-            tile.Parse(tileNode);
+            // Get the tile of the id and parse the element right into it,
+            // the elements of ids out of the tileset are ignored.
+            int id = -1;
+            tileNode->ToElement()->Attribute("id", &id);
 
-            // Using the ID in the temporary tile get the real tile and parse for real.
-            tiles[tile.GetId()]->Parse(tileNode);
+            Tile *tile = AddTile(id);
+            if (tile)
+            {
+                tile->Parse(tileNode, stringPool);
+            }
 
             tileNode = tilesetNode->IterateChildren("tile", tileNode);
 		}
@@ -125,20 +187,78 @@ namespace Tmx
 		
 		if (propertiesNode) 
 		{
-			properties.Parse(propertiesNode);
+			properties.Parse(propertiesNode, stringPool);
 		}
 	}
 
 	const Tile *Tileset::GetTile(int index) const 
 	{
-		for (unsigned int i = 0; i < tiles.size(); ++i) 
+		if (index < 0) 
+		{
+			return NULL;
+		}
+		if (index < (int)tile_table.size())
+		{
+			return tile_table[index];
+		}
+		return index >= GetTableLimit() ? SearchTile(index) : NULL;
+	}
+
+	Tile *Tileset::AddTile(int id)
+	{
+		// The ids of a tileset with an image are those of its tiles.
+		if (id < 0 || (image && tile_count > 0 && id >= tile_count))
 		{
-			if (tiles.at(i)->GetId() == index) 
+			return NULL;
+		}
+
+		// The tiles of large ids, which a tileset without an image may
+		// have, are only kept sorted.
+		Tile *tile;
+		if (id < GetTableLimit())
+		{
+			if (id >= (int)tile_table.size())
 			{
-				return tiles.at(i);
+				tile_table.resize(id + 1, NULL);
 			}
+			if (tile_table[id])
+			{
+				return tile_table[id];
+			}
+
+			tile = arena ? arena->New< Tile >(id) : new Tile(id);
+			tile_table[id] = tile;
 		}
+		else
+		{
+			if ((tile = SearchTile(id)) != NULL)
+			{
+				return tile;
+			}
+
+			tile = arena ? arena->New< Tile >(id) : new Tile(id);
+		}
+
+		// Keep the tiles sorted, they are mostly added in order.
+		if (tiles.empty() || tiles.back()->GetId() < id)
+		{
+			tiles.push_back(tile);
+		}
+		else
+		{
+			tiles.insert(std::lower_bound(tiles.begin(), tiles.end(), id, TileIdLess), tile);
+		}
+		return tile;
+	}
 
-		return NULL;
+	int Tileset::GetTableLimit() const
+	{
+		return tile_count > 0 && tile_count < MaxTableSize ? tile_count : MaxTableSize;
+	}
+
+	Tile *Tileset::SearchTile(int id) const
+	{
+		vector< Tile* >::const_iterator iter = std::lower_bound(tiles.begin(), tiles.end(), id, TileIdLess);
+		return iter != tiles.end() && (*iter)->GetId() == id ? *iter : NULL;
 	}
 };
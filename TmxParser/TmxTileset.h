@@ -36,6 +36,8 @@ class TiXmlNode;
 
 namespace Tmx 
 {
+	class Arena;
+	class StringPool;
 	class Image;
 	class Tile;
 
@@ -46,13 +48,27 @@ namespace Tmx
 	//-------------------------------------------------------------------------
 	class Tileset 
 	{
+		friend class BinaryMap;
+
 	public:
 		Tileset();
+
+		// Make a tileset whose tiles are made in an arena, they are left
+		// for the arena to destroy.
+		Tileset(Tmx::Arena *_arena);
 		~Tileset();
 
 		// Parse a tileset element.
 		void Parse(const TiXmlNode *tilesetNode);
 
+		// Parse a tileset element, without the properties of its tiles
+		// unless parseTiles is set.
+		void Parse(const TiXmlNode *tilesetNode, bool parseTiles);
+
+		// Parse a tileset element, interning the strings of the properties
+		// in a pool which outlives the tileset.
+		void Parse(const TiXmlNode *tilesetNode, bool parseTiles, Tmx::StringPool *stringPool);
+
 		// Returns the global id of the first tile.
 		int GetFirstGid() const { return first_gid; }
 
@@ -75,16 +91,35 @@ namespace Tmx
 		// about the image of the tileset.
 		const Tmx::Image* GetImage() const { return image; }
 
-		// Returns a a single tile of the set.
+		// Get the number of tiles of the tileset, from its tilecount
+		// attribute or else its image, 0 if it has neither.
+		int GetNumTiles() const { return tile_count; }
+
+		// Returns a a single tile of the set, by its id.
+		// Only the tiles described in the tileset, which have properties,
+		// are kept. Returns NULL for the others.
 		const Tmx::Tile *GetTile(int index) const;
 
-		// Returns the whole tile collection.
+		// Returns the tiles described in the tileset, sorted by their id.
 		const std::vector< Tmx::Tile *> &GetTiles() const { return tiles; } 
 		
 		// Get a set of properties regarding the tile.
 		const Tmx::PropertySet &GetProperties() const { return properties; }
 
 	private:
+		// Get the tile of an id, adding it if there is none yet.
+		// Returns NULL if the id is out of the tileset.
+		Tmx::Tile *AddTile(int id);
+
+		// Get the amount of ids the table of tiles may cover.
+		int GetTableLimit() const;
+
+		// Find a tile beyond the table by a search of the sorted tiles.
+		Tmx::Tile *SearchTile(int id) const;
+
+		Tmx::Arena *arena;
+		Tmx::StringPool *own_pool;
+
 		int first_gid;
 		
 		std::string name;
@@ -93,10 +128,16 @@ namespace Tmx
 		int tile_height;
 		int margin;
 		int spacing;
+		int tile_count;
 		
 		Tmx::Image* image;
 
 		std::vector< Tmx::Tile* > tiles;
+
+		// The tiles by their id, NULL for those not described. The ids
+		// beyond GetTableLimit(), of tilesets without an image, are only
+		// in the sorted tiles.
+		std::vector< Tmx::Tile* > tile_table;
 		
 		Tmx::PropertySet properties;
 	};
@@ -26,17 +26,206 @@
 // Author: Tamir Atias
 //-----------------------------------------------------------------------------
 #include <stdlib.h>
+#include <string.h>
 #include <zlib.h>
 
 #include "TmxUtil.h"
 #include "base64/base64.h"
+#define ZSTD_STATIC_LINKING_ONLY
+#include "zstd/zstd.h"
+#include "TmxThreads.h"
 
 namespace Tmx {
+	//-------------------------------------------------------------------------
+	// A zlib stream and a zstd context, reset rather than set up again for
+	// each layer which is decompressed. The base-64 text is decoded a chunk
+	// at a time into a buffer on the stack and the data is decompressed
+	// straight into the buffer of the layer.
+	//-------------------------------------------------------------------------
+	class Decompressor
+	{
+	private:
+		// Prevent copy constructor.
+		Decompressor(const Decompressor &_decompressor);
+		Decompressor &operator=(const Decompressor &_decompressor);
+
+	public:
+		// The amount of compressed bytes decoded at a time.
+		static const size_t ChunkSize = 16384;
+
+		Decompressor()
+			: is_inflate_initialized(false)
+			, zstd_context(NULL)
+		{
+			memset(&stream, 0, sizeof(stream));
+		}
+
+		~Decompressor()
+		{
+			if (is_inflate_initialized)
+			{
+				inflateEnd(&stream);
+			}
+			ZSTD_freeDCtx(zstd_context);
+		}
+
+		// Decode and inflate base-64 text, zlib or gzip data, into a buffer
+		// of outSize bytes. Returns the amount of bytes written, or -1 if
+		// the data is invalid, incomplete or does not fit.
+		long Inflate(const char *data, size_t dataSize, unsigned char *out, size_t outSize)
+		{
+			// Detect zlib and gzip headers automatically.
+			if (!is_inflate_initialized)
+			{
+				if (inflateInit2(&stream, 15 + 32) != Z_OK)
+				{
+					return -1;
+				}
+				is_inflate_initialized = true;
+			}
+			else if (inflateReset(&stream) != Z_OK)
+			{
+				return -1;
+			}
+
+			stream.next_out = (Bytef*)out;
+			stream.avail_out = (uInt)outSize;
+
+			// The whole of the output is there, so a stream which fits in a
+			// single chunk is finished in one call without a sliding window.
+			unsigned char chunk[ChunkSize];
+			int ret = Z_BUF_ERROR;
+			while (ret != Z_STREAM_END)
+			{
+				const long decoded = DecodeChunk(data, dataSize, chunk);
+				if (decoded <= 0)
+				{
+					return -1;
+				}
+				stream.next_in = chunk;
+				stream.avail_in = (uInt)decoded;
+
+				// The stream needs more input once the chunk is consumed,
+				// it does not fit if the buffer is full first.
+				ret = inflate(&stream, Z_FINISH);
+				if (ret != Z_STREAM_END && (ret != Z_BUF_ERROR || stream.avail_in != 0))
+				{
+					return -1;
+				}
+			}
+			return (long)(outSize - stream.avail_out);
+		}
+
+		// Decode and decompress base-64 text, zstd data, into a buffer of
+		// outSize bytes, with the same results as Inflate().
+		long DecompressZstd(const char *data, size_t dataSize, unsigned char *out, size_t outSize)
+		{
+			if (!zstd_context)
+			{
+				// The output buffer stays the same, so the frames are
+				// decompressed into it rather than into a window of their own.
+				if (!(zstd_context = ZSTD_createDCtx())
+					|| ZSTD_isError(ZSTD_DCtx_setParameter(zstd_context, ZSTD_d_stableOutBuffer, 1)))
+				{
+					ZSTD_freeDCtx(zstd_context);
+					zstd_context = NULL;
+					return -1;
+				}
+			}
+			else
+			{
+				ZSTD_DCtx_reset(zstd_context, ZSTD_reset_session_only);
+			}
+
+			ZSTD_outBuffer output = { out, outSize, 0 };
+			unsigned char chunk[ChunkSize];
+			size_t ret = 1;
+			while (ret != 0)
+			{
+				const long decoded = DecodeChunk(data, dataSize, chunk);
+				if (decoded <= 0)
+				{
+					return -1;
+				}
+				ZSTD_inBuffer input = { chunk, (size_t)decoded, 0 };
+
+				// A frame which is not done once the chunk is consumed needs
+				// more input, it does not fit if the buffer is full first.
+				ret = ZSTD_decompressStream(zstd_context, &output, &input);
+				if (ZSTD_isError(ret) || (ret != 0 && input.pos != input.size))
+				{
+					return -1;
+				}
+			}
+			return (long)output.pos;
+		}
+
+	private:
+		// Decode the next chunk of base-64 text and move past it. Returns the
+		// amount of bytes decoded, 0 at the end of the text, or -1 if the
+		// text is invalid.
+		static long DecodeChunk(const char *&data, size_t &dataSize, unsigned char *chunk)
+		{
+			size_t used = 0;
+			size_t decoded = 0;
+			if (!base64_decode(data, dataSize, chunk, ChunkSize, &used, &decoded))
+			{
+				return -1;
+			}
+			data += used;
+			dataSize -= used;
+			return (long)decoded;
+		}
+
+		z_stream stream;
+		bool is_inflate_initialized;
+
+		ZSTD_DCtx *zstd_context;
+	};
+
+	// Decode base-64 text a chunk at a time and decompress it, with zstd or
+	// with zlib.
+	static long DecodeAndDecompress(const char *data, size_t dataSize, unsigned char *out, size_t outSize, bool zstd)
+	{
+		// Every thread keeps a decompressor of its own where thread_local
+		// is there.
+#ifdef TMX_USE_THREADS
+		static thread_local Decompressor decompressor;
+#else
+		Decompressor decompressor;
+#endif
+
+		return zstd
+			? decompressor.DecompressZstd(data, dataSize, out, outSize)
+			: decompressor.Inflate(data, dataSize, out, outSize);
+	}
+
 	std::string Util::DecodeBase64(const std::string &str) 
 	{
 		return base64_decode(str);
 	}
 
+	long Util::DecodeBase64(const char *data, size_t dataSize, unsigned char *out, size_t outSize)
+	{
+		size_t used = 0;
+		size_t written = 0;
+		if (!base64_decode(data, dataSize, out, outSize, &used, &written) || used != dataSize)
+		{
+			return -1;
+		}
+		return (long)written;
+	}
+
+	long Util::DecodeCompressedBase64(const char *data, size_t dataSize, unsigned char *out, size_t outSize)
+	{
+		return DecodeAndDecompress(data, dataSize, out, outSize, false);
+	}
+
+	long Util::DecodeZstdBase64(const char *data, size_t dataSize, unsigned char *out, size_t outSize)
+	{
+		return DecodeAndDecompress(data, dataSize, out, outSize, true);
+	}
+
 	char *Util::DecompressGZIP(const char *data, int dataSize, int expectedSize) 
 	{
 		int bufferSize = expectedSize;
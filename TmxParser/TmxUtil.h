@@ -27,6 +27,7 @@
 //-----------------------------------------------------------------------------
 #pragma once
 
+#include <stddef.h>
 #include <string>
 
 namespace Tmx 
@@ -37,6 +38,22 @@ namespace Tmx
 		// Decode a base-64 encoded string.
 		static std::string DecodeBase64(const std::string &str);
 
+		// Decode base-64 encoded text into a buffer of outSize bytes, white
+		// space is skipped. Returns the amount of bytes written, or -1 if
+		// the text is invalid or does not fit in the buffer.
+		static long DecodeBase64(const char *data, size_t dataSize, unsigned char *out, size_t outSize);
+
+		// Decode base-64 encoded zlib or gzip data and decompress it into a
+		// buffer of outSize bytes. The text is decoded a chunk at a time and
+		// inflated straight into the buffer, with a zlib stream each thread
+		// reuses. Returns the amount of bytes
+		// written, or -1 if the data is invalid or does not fit.
+		static long DecodeCompressedBase64(const char *data, size_t dataSize, unsigned char *out, size_t outSize);
+
+		// Decode base-64 encoded zstd data and decompress it into a buffer
+		// of outSize bytes, in the same way as DecodeCompressedBase64().
+		static long DecodeZstdBase64(const char *data, size_t dataSize, unsigned char *out, size_t outSize);
+
 		// Decompress a gzip encoded byte array.
 		static char* DecompressGZIP(const char *data, int dataSize, int expectedSize);
 	};
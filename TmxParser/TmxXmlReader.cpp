@@ -0,0 +1,430 @@
+//-----------------------------------------------------------------------------
+// TmxXmlReader.cpp
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#include <tinyxml.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TmxXmlReader.h"
+
+namespace Tmx
+{
+	// Find a token in [from, end), returns end if it is missing.
+	static const char *FindToken(const char *from, const char *end, const char *token)
+	{
+		const size_t length = strlen(token);
+		while (from + length <= end)
+		{
+			from = (const char *)memchr(from, token[0], end - from);
+			if (!from || from + length > end)
+			{
+				break;
+			}
+			if (memcmp(from, token, length) == 0)
+			{
+				return from;
+			}
+			++from;
+		}
+		return end;
+	}
+
+	static bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+	}
+
+	// Append a code point encoded in UTF-8.
+	static void AppendUTF8(unsigned long c, std::string &out)
+	{
+		if (c < 0x80)
+		{
+			out += (char)c;
+		}
+		else if (c < 0x800)
+		{
+			out += (char)(0xC0 | (c >> 6));
+			out += (char)(0x80 | (c & 0x3F));
+		}
+		else if (c < 0x10000)
+		{
+			out += (char)(0xE0 | (c >> 12));
+			out += (char)(0x80 | ((c >> 6) & 0x3F));
+			out += (char)(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			out += (char)(0xF0 | (c >> 18));
+			out += (char)(0x80 | ((c >> 12) & 0x3F));
+			out += (char)(0x80 | ((c >> 6) & 0x3F));
+			out += (char)(0x80 | (c & 0x3F));
+		}
+	}
+
+	// Decode the entities of an attribute value.
+	static void Unescape(const char *p, size_t length, std::string &out)
+	{
+		const char *end = p + length;
+		out.clear();
+		out.reserve(length);
+		while (p < end)
+		{
+			const char *amp = (const char *)memchr(p, '&', end - p);
+			if (!amp)
+			{
+				out.append(p, end);
+				break;
+			}
+			out.append(p, amp);
+
+			const char *semicolon = (const char *)memchr(amp, ';', end - amp);
+			if (!semicolon)
+			{
+				out.append(amp, end);
+				break;
+			}
+
+			const std::string entity(amp + 1, semicolon);
+			if (entity == "lt") out += '<';
+			else if (entity == "gt") out += '>';
+			else if (entity == "amp") out += '&';
+			else if (entity == "quot") out += '"';
+			else if (entity == "apos") out += '\'';
+			else if (entity.size() > 1 && entity[0] == '#')
+			{
+				const bool hex = entity[1] == 'x';
+				AppendUTF8(strtoul(entity.c_str() + (hex ? 2 : 1), NULL, hex ? 16 : 10), out);
+			}
+			else
+			{
+				// Unknown entities are kept as they are.
+				out.append(amp, semicolon + 1);
+			}
+			p = semicolon + 1;
+		}
+	}
+
+	XmlReader::XmlReader(const char *data, size_t size)
+		: pos(data)
+		, end(data + size)
+		, name(NULL)
+		, name_length(0)
+		, element_begin(NULL)
+		, attributes()
+		, empty_element(false)
+		, open_elements()
+		, text(NULL)
+		, text_length(0)
+		, has_error(false)
+		, error_text()
+	{}
+
+	XmlReader::~XmlReader()
+	{}
+
+	XmlNodeType XmlReader::Fail(const char *message)
+	{
+		has_error = true;
+		error_text = message;
+		return XML_ERROR;
+	}
+
+	const char *XmlReader::ReadName(const char *p) const
+	{
+		while (p < end && !IsSpace(*p) && *p != '/' && *p != '>' && *p != '=')
+		{
+			++p;
+		}
+		return p;
+	}
+
+	XmlNodeType XmlReader::Read()
+	{
+		if (has_error)
+		{
+			return XML_ERROR;
+		}
+
+		// The start of an empty element is followed by its end.
+		if (empty_element)
+		{
+			empty_element = false;
+			return XML_END_ELEMENT;
+		}
+
+		while (pos < end)
+		{
+			if (*pos != '<')
+			{
+				const char *textEnd = (const char *)memchr(pos, '<', end - pos);
+				if (!textEnd)
+				{
+					textEnd = end;
+				}
+				text = pos;
+				text_length = textEnd - pos;
+				pos = textEnd;
+				return XML_TEXT;
+			}
+
+			const size_t left = end - pos;
+			if (left >= 4 && memcmp(pos, "<!--", 4) == 0)
+			{
+				const char *close = FindToken(pos + 4, end, "-->");
+				if (close == end)
+				{
+					return Fail("Unterminated comment.");
+				}
+				pos = close + 3;
+				continue;
+			}
+			if (left >= 9 && memcmp(pos, "<![CDATA[", 9) == 0)
+			{
+				const char *close = FindToken(pos + 9, end, "]]>");
+				if (close == end)
+				{
+					return Fail("Unterminated CDATA section.");
+				}
+				text = pos + 9;
+				text_length = close - text;
+				pos = close + 3;
+				return XML_TEXT;
+			}
+			if (left >= 2 && pos[1] == '?')
+			{
+				const char *close = FindToken(pos + 2, end, "?>");
+				if (close == end)
+				{
+					return Fail("Unterminated processing instruction.");
+				}
+				pos = close + 2;
+				continue;
+			}
+			if (left >= 2 && pos[1] == '!')
+			{
+				const char *close = (const char *)memchr(pos, '>', left);
+				if (!close)
+				{
+					return Fail("Unterminated document type.");
+				}
+				pos = close + 1;
+				continue;
+			}
+
+			if (left >= 2 && pos[1] == '/')
+			{
+				// An end tag has to close the last open element.
+				name = pos + 2;
+				const char *nameEnd = ReadName(name);
+				name_length = nameEnd - name;
+				while (nameEnd < end && IsSpace(*nameEnd))
+				{
+					++nameEnd;
+				}
+				if (nameEnd >= end || *nameEnd != '>')
+				{
+					return Fail("Malformed end tag.");
+				}
+				if (open_elements.empty()
+					|| open_elements.back().second != name_length
+					|| memcmp(open_elements.back().first, name, name_length) != 0)
+				{
+					return Fail("Mismatched end tag.");
+				}
+				open_elements.pop_back();
+				pos = nameEnd + 1;
+				return XML_END_ELEMENT;
+			}
+
+			// A start tag, with its attributes.
+			element_begin = pos;
+			name = pos + 1;
+			const char *p = ReadName(name);
+			name_length = p - name;
+			if (name_length == 0)
+			{
+				return Fail("Malformed start tag.");
+			}
+
+			attributes.clear();
+			while (true)
+			{
+				while (p < end && IsSpace(*p))
+				{
+					++p;
+				}
+				if (p >= end)
+				{
+					return Fail("Unterminated start tag.");
+				}
+				if (*p == '>')
+				{
+					++p;
+					break;
+				}
+				if (*p == '/')
+				{
+					if (p + 1 >= end || p[1] != '>')
+					{
+						return Fail("Malformed start tag.");
+					}
+					p += 2;
+					empty_element = true;
+					break;
+				}
+
+				Attribute attribute;
+				attribute.name = p;
+				p = ReadName(p);
+				attribute.name_length = p - attribute.name;
+				while (p < end && IsSpace(*p))
+				{
+					++p;
+				}
+				if (attribute.name_length == 0 || p >= end || *p != '=')
+				{
+					return Fail("Malformed attribute.");
+				}
+				++p;
+				while (p < end && IsSpace(*p))
+				{
+					++p;
+				}
+				if (p >= end || (*p != '"' && *p != '\''))
+				{
+					return Fail("Malformed attribute.");
+				}
+				const char *close = (const char *)memchr(p + 1, *p, end - p - 1);
+				if (!close)
+				{
+					return Fail("Unterminated attribute value.");
+				}
+				attribute.value = p + 1;
+				attribute.value_length = close - attribute.value;
+				attributes.push_back(attribute);
+				p = close + 1;
+			}
+
+			if (!empty_element)
+			{
+				open_elements.push_back(std::make_pair(name, name_length));
+			}
+			pos = p;
+			return XML_START_ELEMENT;
+		}
+
+		if (!open_elements.empty())
+		{
+			return Fail("Unexpected end of document.");
+		}
+		return XML_END_OF_DOCUMENT;
+	}
+
+	bool XmlReader::IsElement(const char *elementName) const
+	{
+		return strlen(elementName) == name_length && memcmp(elementName, name, name_length) == 0;
+	}
+
+	const XmlReader::Attribute *XmlReader::FindAttribute(const char *attributeName) const
+	{
+		const size_t length = strlen(attributeName);
+		for (unsigned int i = 0; i < attributes.size(); ++i)
+		{
+			const Attribute &attribute = attributes[i];
+			if (attribute.name_length == length && memcmp(attribute.name, attributeName, length) == 0)
+			{
+				return &attribute;
+			}
+		}
+		return NULL;
+	}
+
+	bool XmlReader::GetAttribute(const char *attributeName, std::string &value) const
+	{
+		const Attribute *attribute = FindAttribute(attributeName);
+		if (!attribute)
+		{
+			return false;
+		}
+		Unescape(attribute->value, attribute->value_length, value);
+		return true;
+	}
+
+	int XmlReader::GetIntAttribute(const char *attributeName, int defaultValue) const
+	{
+		std::string value;
+		return GetAttribute(attributeName, value) ? atoi(value.c_str()) : defaultValue;
+	}
+
+	double XmlReader::GetDoubleAttribute(const char *attributeName, double defaultValue) const
+	{
+		std::string value;
+		return GetAttribute(attributeName, value) ? atof(value.c_str()) : defaultValue;
+	}
+
+	bool XmlReader::Skip()
+	{
+		int depth = 1;
+		while (depth > 0)
+		{
+			switch (Read())
+			{
+			case XML_START_ELEMENT:
+				++depth;
+				break;
+			case XML_END_ELEMENT:
+				--depth;
+				break;
+			case XML_TEXT:
+				break;
+			default:
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool XmlReader::ReadFragment(TiXmlDocument &document)
+	{
+		const char *begin = element_begin;
+		if (!Skip())
+		{
+			return false;
+		}
+
+		// TinyXML parses null terminated strings only.
+		const std::string fragment(begin, pos);
+		document.Parse(fragment.c_str());
+		if (document.Error())
+		{
+			has_error = true;
+			error_text = document.ErrorDesc();
+			return false;
+		}
+		return true;
+	}
+};
@@ -0,0 +1,140 @@
+//-----------------------------------------------------------------------------
+// TmxXmlReader.h
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#pragma once
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+class TiXmlDocument;
+
+namespace Tmx
+{
+	//-------------------------------------------------------------------------
+	// Type of the nodes found by the XmlReader.
+	//-------------------------------------------------------------------------
+	enum XmlNodeType
+	{
+		// The start of an element, its attributes can be read.
+		XML_START_ELEMENT,
+
+		// The end of an element, also given right after the start of an
+		// empty element.
+		XML_END_ELEMENT,
+
+		// Character data, either plain text or a CDATA section.
+		XML_TEXT,
+
+		// The end of the document.
+		XML_END_OF_DOCUMENT,
+
+		// The document is not well formed, see GetErrorText().
+		XML_ERROR
+	};
+
+	//-------------------------------------------------------------------------
+	// A pull parser reading the nodes of an XML document one by one from a
+	// buffer, without building a tree or copying the text.
+	// Comments, processing instructions and the document type are skipped.
+	// Elements which are small and complex can still be read into a
+	// TinyXML document with ReadFragment().
+	//-------------------------------------------------------------------------
+	class XmlReader
+	{
+	public:
+		XmlReader(const char *data, size_t size);
+		~XmlReader();
+
+		// Read the next node.
+		XmlNodeType Read();
+
+		// Get whether the current element has this name.
+		bool IsElement(const char *name) const;
+
+		// Get the name of the current element.
+		std::string GetName() const { return std::string(name, name_length); }
+
+		// Get the value of an attribute of the current start element,
+		// with the entities decoded. Returns false if it is missing.
+		bool GetAttribute(const char *attributeName, std::string &value) const;
+
+		// Get the value of an attribute as an integer or a double.
+		int GetIntAttribute(const char *attributeName, int defaultValue) const;
+		double GetDoubleAttribute(const char *attributeName, double defaultValue) const;
+
+		// Get the raw character data of the current text node.
+		const char *GetText() const { return text; }
+		size_t GetTextLength() const { return text_length; }
+
+		// Skip the content of the current start element up to its end.
+		bool Skip();
+
+		// Read the current start element with all of its content into a
+		// TinyXML document, the element is the first child of the document.
+		bool ReadFragment(TiXmlDocument &document);
+
+		// Get whether the document is not well formed.
+		bool HasError() const { return has_error; }
+
+		// Get an error string containing the error in text format.
+		const std::string &GetErrorText() const { return error_text; }
+
+	private:
+		struct Attribute
+		{
+			const char *name;
+			size_t name_length;
+			const char *value;
+			size_t value_length;
+		};
+
+		XmlNodeType Fail(const char *message);
+		const Attribute *FindAttribute(const char *attributeName) const;
+		const char *ReadName(const char *p) const;
+
+		const char *pos;
+		const char *end;
+
+		// The current element.
+		const char *name;
+		size_t name_length;
+		const char *element_begin;
+		std::vector< Attribute > attributes;
+		bool empty_element;
+
+		// The names of the open elements.
+		std::vector< std::pair< const char*, size_t > > open_elements;
+
+		// The current text node.
+		const char *text;
+		size_t text_length;
+
+		bool has_error;
+		std::string error_text;
+	};
+};
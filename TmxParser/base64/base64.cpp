@@ -23,6 +23,9 @@
 
    Ren Nyffenegger rene.nyffenegger@adp-gmbh.ch
 
+   This is an altered version: the decoder is table driven, skips white
+   space, validates its input and has SSSE3 and AVX2 kernels.
+
 */
 
 #include "base64.h"
@@ -34,10 +37,6 @@ static const std::string base64_chars =
              "0123456789+/";
 
 
-static inline bool is_base64(unsigned char c) {
-  return (isalnum(c) || (c == '+') || (c == '/'));
-}
-
 std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_len) {
   std::string ret;
   int i = 0;
@@ -81,43 +80,263 @@ std::string base64_encode(unsigned char const* bytes_to_encode, unsigned int in_
 
 }
 
-std::string base64_decode(std::string const& encoded_string) {
-  int in_len = encoded_string.size();
-  int i = 0;
-  int j = 0;
-  int in_ = 0;
-  unsigned char char_array_4[4], char_array_3[3];
-  std::string ret;
+/*
+   Decoding table: the value of every base64 character, white space and
+   padding are marked so that a group of 4 characters is valid when none
+   of its values has one of the two high bits set.
+*/
+enum {
+  B64_SPACE   = 0x80,
+  B64_PAD     = 0x81,
+  B64_INVALID = 0xFF
+};
+
+static const unsigned char base64_table[256] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x80, 0x80, 0xFF, 0xFF, 0x80, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0x80, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,   62, 0xFF, 0xFF, 0xFF,   63,
+    52,   53,   54,   55,   56,   57,   58,   59,   60,   61, 0xFF, 0xFF, 0xFF, 0x81, 0xFF, 0xFF,
+  0xFF,    0,    1,    2,    3,    4,    5,    6,    7,    8,    9,   10,   11,   12,   13,   14,
+    15,   16,   17,   18,   19,   20,   21,   22,   23,   24,   25, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF,   26,   27,   28,   29,   30,   31,   32,   33,   34,   35,   36,   37,   38,   39,   40,
+    41,   42,   43,   44,   45,   46,   47,   48,   49,   50,   51, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
 
-  while (in_len-- && ( encoded_string[in_] != '=') && is_base64(encoded_string[in_])) {
-    char_array_4[i++] = encoded_string[in_]; in_++;
-    if (i ==4) {
-      for (i = 0; i <4; i++)
-        char_array_4[i] = base64_chars.find(char_array_4[i]);
+/*
+   SIMD kernels, they decode blocks of 16 or 32 characters as long as the
+   characters are all in the alphabet and leave the rest (white space,
+   padding, errors and the tail) to the table driven loop.
+   The translation and the validation use the nibble lookups described by
+   Wojciech Mula and used by Alfred Klomp's base64 library.
+*/
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define BASE64_X86
 
-      char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-      char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-      char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define BASE64_TARGET(x)
+#else
+#define BASE64_TARGET(x) __attribute__((target(x)))
+#endif
 
-      for (i = 0; (i < 3); i++)
-        ret += char_array_3[i];
-      i = 0;
-    }
+typedef void (*base64_kernel)(const unsigned char *&in, const unsigned char *in_end,
+                              unsigned char *&out, unsigned char *out_end);
+
+BASE64_TARGET("ssse3")
+static void base64_decode_ssse3(const unsigned char *&in, const unsigned char *in_end,
+                                unsigned char *&out, unsigned char *out_end) {
+  const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                       0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                       0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                         0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i mask_2f = _mm_set1_epi8(0x2F);
+  const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+  // 16 characters give 12 bytes but 16 are stored
+  while (in_end - in >= 16 && out_end - out >= 16) {
+    __m128i str = _mm_loadu_si128((const __m128i *)in);
+
+    const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2f);
+    const __m128i lo_nibbles = _mm_and_si128(str, mask_2f);
+    const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+    const __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0)
+      break;
+
+    const __m128i eq_2f = _mm_cmpeq_epi8(str, mask_2f);
+    const __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+    str = _mm_add_epi8(str, roll);
+
+    // pack the 6 bit values into 3 bytes per group of 4
+    str = _mm_maddubs_epi16(str, _mm_set1_epi32(0x01400140));
+    str = _mm_madd_epi16(str, _mm_set1_epi32(0x00011000));
+    str = _mm_shuffle_epi8(str, pack);
+    _mm_storeu_si128((__m128i *)out, str);
+
+    in += 16;
+    out += 12;
+  }
+}
+
+BASE64_TARGET("avx2")
+static void base64_decode_avx2(const unsigned char *&in, const unsigned char *in_end,
+                               unsigned char *&out, unsigned char *out_end) {
+  const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                          0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+                                          0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                          0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                          0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                          0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                          0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71,
+                                            0, 0, 0, 0, 0, 0, 0, 0,
+                                            0, 16, 19, 4, -65, -65, -71, -71,
+                                            0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i mask_2f = _mm256_set1_epi8(0x2F);
+  const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                        2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+
+  // 32 characters give 24 bytes but 32 are stored
+  while (in_end - in >= 32 && out_end - out >= 32) {
+    __m256i str = _mm256_loadu_si256((const __m256i *)in);
+
+    const __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2f);
+    const __m256i lo_nibbles = _mm256_and_si256(str, mask_2f);
+    const __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+    const __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+    if (!_mm256_testz_si256(lo, hi))
+      break;
+
+    const __m256i eq_2f = _mm256_cmpeq_epi8(str, mask_2f);
+    const __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+    str = _mm256_add_epi8(str, roll);
+
+    // pack the 6 bit values into 3 bytes per group of 4, then join the
+    // 12 bytes of both lanes
+    str = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+    str = _mm256_madd_epi16(str, _mm256_set1_epi32(0x00011000));
+    str = _mm256_shuffle_epi8(str, pack);
+    str = _mm256_permutevar8x32_epi32(str, lanes);
+    _mm256_storeu_si256((__m256i *)out, str);
+
+    in += 32;
+    out += 24;
+  }
+}
+
+static void base64_decode_none(const unsigned char *&, const unsigned char *,
+                               unsigned char *&, unsigned char *) {
+}
+
+// Pick the widest kernel the processor and the system support.
+static base64_kernel base64_select_kernel() {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 0);
+  const int max_leaf = info[0];
+  __cpuid(info, 1);
+  const bool ssse3 = (info[2] & (1 << 9)) != 0;
+  const bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx2 = false;
+  if (max_leaf >= 7 && osxsave && (_xgetbv(0) & 6) == 6) {
+    __cpuidex(info, 7, 0);
+    avx2 = (info[1] & (1 << 5)) != 0;
   }
+#else
+  __builtin_cpu_init();
+  const bool ssse3 = __builtin_cpu_supports("ssse3") != 0;
+  const bool avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+  if (avx2) return base64_decode_avx2;
+  if (ssse3) return base64_decode_ssse3;
+  return base64_decode_none;
+}
 
-  if (i) {
-    for (j = i; j <4; j++)
-      char_array_4[j] = 0;
+// Selected once, before main.
+static const base64_kernel base64_decode_simd = base64_select_kernel();
+#endif
 
-    for (j = 0; j <4; j++)
-      char_array_4[j] = base64_chars.find(char_array_4[j]);
+bool base64_decode(const char *in, size_t in_len, unsigned char *out, size_t out_len,
+                   size_t *in_used, size_t *out_used) {
+  const unsigned char *p = (const unsigned char *)in;
+  const unsigned char *const end = p + in_len;
+  unsigned char *o = out;
+  unsigned char *const out_end = out + out_len;
+  bool valid = true;
 
-    char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-    char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-    char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+  for (;;) {
+#ifdef BASE64_X86
+    base64_decode_simd(p, end, o, out_end);
+#endif
 
-    for (j = 0; (j < i - 1); j++) ret += char_array_3[j];
+    // groups of 4 characters of the alphabet
+    while (end - p >= 4 && out_end - o >= 3) {
+      const unsigned char a = base64_table[p[0]], b = base64_table[p[1]];
+      const unsigned char c = base64_table[p[2]], d = base64_table[p[3]];
+      if ((a | b | c | d) & 0xC0)
+        break;
+      o[0] = (unsigned char)((a << 2) | (b >> 4));
+      o[1] = (unsigned char)((b << 4) | (c >> 2));
+      o[2] = (unsigned char)((c << 6) | d);
+      p += 4;
+      o += 3;
+    }
+
+    // a group broken by white space, padding, an error or the end
+    unsigned char v[4];
+    int n = 0;
+    const unsigned char *q = p;
+    for (; q < end && n < 4; ++q) {
+      const unsigned char value = base64_table[*q];
+      if (value < 64)
+        v[n++] = value;
+      else if (value != B64_SPACE)
+        break;
+    }
+    if (n == 4) {
+      if (out_end - o < 3)
+        break;
+      o[0] = (unsigned char)((v[0] << 2) | (v[1] >> 4));
+      o[1] = (unsigned char)((v[1] << 4) | (v[2] >> 2));
+      o[2] = (unsigned char)((v[2] << 6) | v[3]);
+      o += 3;
+      p = q;
+      continue;
+    }
+
+    // the last group, with 2 or 3 characters before the padding or the end
+    const bool padded = q < end && base64_table[*q] == B64_PAD;
+    if (q < end && !padded) {
+      valid = false;
+    }
+    else if (n == 1) {
+      valid = false;
+    }
+    else if (n > 1) {
+      if (out_end - o < n - 1)
+        break;
+      o[0] = (unsigned char)((v[0] << 2) | (v[1] >> 4));
+      if (n == 3)
+        o[1] = (unsigned char)((v[1] << 4) | (v[2] >> 2));
+      o += n - 1;
+    }
+
+    // only padding and white space may follow
+    for (; q < end; ++q) {
+      const unsigned char value = base64_table[*q];
+      if (value != B64_SPACE && value != B64_PAD) {
+        valid = false;
+        break;
+      }
+    }
+    p = q;
+    break;
   }
 
+  if (in_used) *in_used = p - (const unsigned char *)in;
+  if (out_used) *out_used = o - out;
+  return valid;
+}
+
+std::string base64_decode(std::string const& encoded_string) {
+  std::string ret(base64_decoded_size_max(encoded_string.size()), '\0');
+  size_t out_len = 0;
+  if (!ret.empty())
+    base64_decode(encoded_string.data(), encoded_string.size(),
+                  (unsigned char *)&ret[0], ret.size(), NULL, &out_len);
+  ret.resize(out_len);
   return ret;
-}
\ No newline at end of file
+}
@@ -23,13 +23,32 @@
 
    Ren Nyffenegger rene.nyffenegger@adp-gmbh.ch
 
+   This is an altered version: the decoder is table driven, skips white
+   space, validates its input and has SSSE3 and AVX2 kernels.
+
 */
 #ifndef TMXPARSER_BASE64_H_
 #define TMXPARSER_BASE64_H_
 
+#include <stddef.h>
 #include <string>
 
 std::string base64_encode(unsigned char const* , unsigned int len);
 std::string base64_decode(std::string const& s);
 
+/* The largest amount of bytes which in_len characters can decode to. */
+inline size_t base64_decoded_size_max(size_t in_len) { return (in_len + 3) / 4 * 3; }
+
+/*
+   Decode in_len characters of base64 text into out, which has room for
+   out_len bytes. White space is skipped and the text ends at its padding
+   or at in_len. Decoding stops early, between two groups of 4 characters,
+   when out is full so it can be resumed from in + *in_used.
+   in_used and out_used receive the amount of characters read and bytes
+   written. Returns false if the text has an invalid character, the bytes
+   decoded before it are still written.
+*/
+bool base64_decode(const char *in, size_t in_len, unsigned char *out, size_t out_len,
+                   size_t *in_used, size_t *out_used);
+
 #endif
\ No newline at end of file
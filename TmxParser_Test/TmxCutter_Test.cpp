@@ -0,0 +1,100 @@
+//-----------------------------------------------------------------------------
+// TmxCutter_Test.cpp
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#include "../tmxcutter/rect_union.h"
+#include <cstdio>
+#include <stdlib.h>
+#include <vector>
+
+// Checks the union of rectangles of the cutter against a brute force count
+// of the pixels of random rectangles.
+// Usage: TmxCutter_Test [trials]
+
+// The pixels the rectangles are drawn in, the rectangles reach out of the
+// grid by at most Margin pixels on every side.
+static const int GridSize = 48;
+static const int Margin = 8;
+
+// Add one to every pixel of a rectangle, inverted rectangles are empty.
+static void Draw(const dyb::PixelRect &rect, std::vector< int > &grid) {
+	for (int y = rect.leftTop.y; y <= rect.rightBottom.y; ++y) {
+		for (int x = rect.leftTop.x; x <= rect.rightBottom.x; ++x) {
+			grid[(y + Margin) * (GridSize + 2 * Margin) + x + Margin]++;
+		}
+	}
+}
+
+// Get a random coordinate of the grid.
+static int RandomCoordinate() {
+	return rand() % (GridSize + 2 * Margin) - Margin;
+}
+
+int main(int argc, char **argv) {
+	const int trials = argc > 1 ? atoi(argv[1]) : 2000;
+	const int side = GridSize + 2 * Margin;
+
+	srand(1);
+	for (int trial = 0; trial < trials; ++trial) {
+		// Rectangles of any size, some of them empty, overlapping or touching.
+		std::vector< dyb::PixelRect > rects;
+		const int count = trial % 16;
+		for (int i = 0; i < count; ++i) {
+			dyb::PixelRect rect;
+			rect.leftTop = dyb::ivec2(RandomCoordinate(), RandomCoordinate());
+			rect.rightBottom = dyb::ivec2(rect.leftTop.x + rand() % 20 - 2, rect.leftTop.y + rand() % 20 - 2);
+			if (rect.rightBottom.x >= GridSize + Margin) rect.rightBottom.x = GridSize + Margin - 1;
+			if (rect.rightBottom.y >= GridSize + Margin) rect.rightBottom.y = GridSize + Margin - 1;
+			rects.push_back(rect);
+		}
+
+		std::vector< int > covered(side * side, 0);
+		for (size_t i = 0; i < rects.size(); ++i) {
+			Draw(rects[i], covered);
+		}
+
+		// The union covers every pixel of the rectangles once, and no other.
+		const std::vector< dyb::PixelRect > united = dyb::unite(rects);
+		std::vector< int > drawn(side * side, 0);
+		for (size_t i = 0; i < united.size(); ++i) {
+			if (united[i].rightBottom.x < united[i].leftTop.x || united[i].rightBottom.y < united[i].leftTop.y) {
+				printf("rect union: trial %d has an empty rectangle\n", trial);
+				return 1;
+			}
+			Draw(united[i], drawn);
+		}
+		for (int i = 0; i < side * side; ++i) {
+			if (drawn[i] != (covered[i] > 0 ? 1 : 0)) {
+				printf("rect union: trial %d covers pixel (%d, %d) %d times instead of %d\n",
+					trial, i % side - Margin, i / side - Margin, drawn[i], covered[i] > 0 ? 1 : 0);
+				return 1;
+			}
+		}
+	}
+
+	printf("rect union: %d unions match the pixels of their rectangles\n", trials);
+	return 0;
+}
@@ -0,0 +1,126 @@
+//-----------------------------------------------------------------------------
+// TmxParser_Bench.cpp
+//
+// Copyright (c) 2010-2013, Tamir Atias
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright
+//    notice, this list of conditions and the following disclaimer in the
+//    documentation and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL TAMIR ATIAS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+// Author: Tamir Atias
+//-----------------------------------------------------------------------------
+#include "../TmxParser/Tmx.h"
+#include <cstdio>
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+// Measures the lookup of the tilesets of the gids of a layer.
+// Usage: TmxParser_Bench [tilesets] [tiles]
+
+// The lookup as it was done before, a reverse scan over the tilesets.
+static int FindTilesetIndexByScan(const Tmx::Map *map, int gid)
+{
+	gid &= ~(Tmx::FlippedHorizontallyFlag | Tmx::FlippedVerticallyFlag | Tmx::FlippedDiagonallyFlag);
+
+	for (int i = map->GetNumTilesets() - 1; i > -1; --i)
+	{
+		if (gid >= map->GetTileset(i)->GetFirstGid())
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+static double Seconds(clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv) {
+	const int numTilesets = argc > 1 ? atoi(argv[1]) : 64;
+	const int numTiles = argc > 2 ? atoi(argv[2]) : 4096 * 4096;
+	const int tilesPerTileset = 256;
+
+	// A map with nothing but tilesets.
+	std::string text = "<map version=\"1.0\" orientation=\"orthogonal\" width=\"1\" height=\"1\" tilewidth=\"16\" tileheight=\"16\">";
+	for (int i = 0; i < numTilesets; ++i) {
+		char tileset[256];
+		sprintf(tileset, "<tileset firstgid=\"%d\" name=\"t%d\" tilewidth=\"16\" tileheight=\"16\">"
+			"<image source=\"t.png\" width=\"256\" height=\"256\"/></tileset>", 1 + i * tilesPerTileset, i);
+		text += tileset;
+	}
+	text += "</map>";
+
+	Tmx::Map *map = new Tmx::Map();
+	map->ParseText(text);
+	if (map->HasError()) {
+		printf("error text: %s\n", map->GetErrorText().c_str());
+		return map->GetErrorCode();
+	}
+
+	// Gids in runs of a few tiles of the same tileset, as painted maps have,
+	// some of them flipped and some empty.
+	std::vector< unsigned > gids(numTiles);
+	srand(1);
+	for (int i = 0; i < numTiles; ) {
+		const unsigned base = (unsigned)(rand() % numTilesets) * tilesPerTileset + 1;
+		const int run = 1 + rand() % 16;
+		for (int j = 0; j < run && i < numTiles; ++j, ++i) {
+			const int r = rand();
+			gids[i] = r % 8 == 0 ? 0 : base + (unsigned)(r % tilesPerTileset);
+			if (r % 11 == 0) gids[i] |= Tmx::FlippedHorizontallyFlag;
+		}
+	}
+
+	std::vector< int > scanned(numTiles);
+	std::vector< int > found(numTiles);
+	std::vector< int > batched(numTiles);
+
+	clock_t start = clock();
+	for (int i = 0; i < numTiles; ++i) {
+		scanned[i] = FindTilesetIndexByScan(map, gids[i]);
+	}
+	const double scanTime = Seconds(start);
+
+	start = clock();
+	for (int i = 0; i < numTiles; ++i) {
+		found[i] = map->FindTilesetIndex(gids[i]);
+	}
+	const double findTime = Seconds(start);
+
+	start = clock();
+	map->FindTilesetIndexes(&gids[0], gids.size(), &batched[0]);
+	const double batchTime = Seconds(start);
+
+	if (scanned != found || scanned != batched) {
+		printf("the lookups disagree\n");
+		return 1;
+	}
+
+	printf("%d tilesets, %d tiles\n", numTilesets, numTiles);
+	printf("reverse scan:         %8.3fs %6.2fns/tile\n", scanTime, scanTime * 1e9 / numTiles);
+	printf("FindTilesetIndex:     %8.3fs %6.2fns/tile\n", findTime, findTime * 1e9 / numTiles);
+	printf("FindTilesetIndexes:   %8.3fs %6.2fns/tile\n", batchTime, batchTime * 1e9 / numTiles);
+
+	delete map;
+	return 0;
+}
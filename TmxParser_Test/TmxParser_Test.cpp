@@ -28,6 +28,327 @@
 #include "../TmxParser/Tmx.h"
 #include <cstdio>
 #include <stdlib.h>
+#include <string>
+
+// Get whether two polygons or polylines have the same points.
+template< typename Shape >
+static bool SameShapes(const Shape *a, const Shape *b) {
+	if (!a || !b) {
+		return a == b;
+	}
+	if (a->GetNumPoints() != b->GetNumPoints()) {
+		return false;
+	}
+	for (int i = 0; i < a->GetNumPoints(); ++i) {
+		if (a->GetPoint(i).x != b->GetPoint(i).x || a->GetPoint(i).y != b->GetPoint(i).y) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Get whether two tilesets are the same, with their tiles.
+static bool SameTilesets(const Tmx::Tileset *a, const Tmx::Tileset *b) {
+	if (a->GetFirstGid() != b->GetFirstGid() || a->GetName() != b->GetName()
+		|| a->GetTileWidth() != b->GetTileWidth() || a->GetTileHeight() != b->GetTileHeight()
+		|| a->GetMargin() != b->GetMargin() || a->GetSpacing() != b->GetSpacing()
+		|| a->GetProperties().GetList() != b->GetProperties().GetList()) {
+		return false;
+	}
+
+	if (!a->GetImage() || !b->GetImage()) {
+		if (a->GetImage() != b->GetImage()) {
+			return false;
+		}
+	} else if (a->GetImage()->GetSource() != b->GetImage()->GetSource()
+		|| a->GetImage()->GetWidth() != b->GetImage()->GetWidth()
+		|| a->GetImage()->GetHeight() != b->GetImage()->GetHeight()
+		|| a->GetImage()->GetTransparentColor() != b->GetImage()->GetTransparentColor()) {
+		return false;
+	}
+
+	if (a->GetTiles().size() != b->GetTiles().size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a->GetTiles().size(); ++i) {
+		const Tmx::Tile *tile = a->GetTiles()[i];
+		if (tile->GetId() != b->GetTiles()[i]->GetId()
+			|| tile->GetProperties().GetList() != b->GetTiles()[i]->GetProperties().GetList()
+			|| b->GetTile(tile->GetId()) != b->GetTiles()[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Get whether two layers are the same, with all of their tiles.
+static bool SameLayers(const Tmx::Layer *a, const Tmx::Layer *b) {
+	if (a->GetId() != b->GetId() || a->GetName() != b->GetName()
+		|| a->GetWidth() != b->GetWidth() || a->GetHeight() != b->GetHeight()
+		|| a->IsVisible() != b->IsVisible()
+		|| a->GetProperties().GetList() != b->GetProperties().GetList()) {
+		return false;
+	}
+	for (int y = 0; y < a->GetHeight(); ++y) {
+		for (int x = 0; x < a->GetWidth(); ++x) {
+			if (a->GetTileGid(x, y) != b->GetTileGid(x, y)
+				|| a->GetTileTilesetIndex(x, y) != b->GetTileTilesetIndex(x, y)
+				|| a->GetTileId(x, y) != b->GetTileId(x, y)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// Get whether two object groups are the same, with their objects.
+static bool SameObjectGroups(const Tmx::ObjectGroup *a, const Tmx::ObjectGroup *b) {
+	if (a->GetId() != b->GetId() || a->GetName() != b->GetName()
+		|| a->GetNumObjects() != b->GetNumObjects()
+		|| a->GetProperties().GetList() != b->GetProperties().GetList()) {
+		return false;
+	}
+	for (int i = 0; i < a->GetNumObjects(); ++i) {
+		const Tmx::Object *objectA = a->GetObject(i);
+		const Tmx::Object *objectB = b->GetObject(i);
+		if (objectA->GetId() != objectB->GetId()
+			|| objectA->GetName() != objectB->GetName() || objectA->GetType() != objectB->GetType()
+			|| objectA->GetX() != objectB->GetX() || objectA->GetY() != objectB->GetY()
+			|| objectA->GetWidth() != objectB->GetWidth() || objectA->GetHeight() != objectB->GetHeight()
+			|| objectA->GetGid() != objectB->GetGid()
+			|| (objectA->GetEllipse() == 0) != (objectB->GetEllipse() == 0)
+			|| !SameShapes(objectA->GetPolygon(), objectB->GetPolygon())
+			|| !SameShapes(objectA->GetPolyline(), objectB->GetPolyline())
+			|| objectA->GetProperties().GetList() != objectB->GetProperties().GetList()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Get whether two maps are the same, element by element.
+static bool SameMaps(const Tmx::Map *a, const Tmx::Map *b) {
+	if (a->GetOrientation() != b->GetOrientation()
+		|| a->GetWidth() != b->GetWidth() || a->GetHeight() != b->GetHeight()
+		|| a->GetTileWidth() != b->GetTileWidth() || a->GetTileHeight() != b->GetTileHeight()
+		|| a->GetProperties().GetList() != b->GetProperties().GetList()
+		|| a->GetNumTilesets() != b->GetNumTilesets()
+		|| a->GetNumLayers() != b->GetNumLayers()
+		|| a->GetNumObjectGroups() != b->GetNumObjectGroups()) {
+		return false;
+	}
+	for (int i = 0; i < a->GetNumTilesets(); ++i) {
+		if (!SameTilesets(a->GetTileset(i), b->GetTileset(i))) {
+			return false;
+		}
+	}
+	for (int i = 0; i < a->GetNumLayers(); ++i) {
+		if (!SameLayers(a->GetLayer(i), b->GetLayer(i))) {
+			return false;
+		}
+	}
+	for (int i = 0; i < a->GetNumObjectGroups(); ++i) {
+		if (!SameObjectGroups(a->GetObjectGroup(i), b->GetObjectGroup(i))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Get whether a buffer is rejected as a map with an error.
+static bool IsRejected(const std::string &data) {
+	Tmx::Map map;
+	map.ParseBuffer(data.data(), data.size());
+	return map.HasError();
+}
+
+// Write a map in the binary format, read it back with both layer storages
+// and check that damaged copies of the file are rejected.
+static bool TestBinaryMap(const Tmx::Map *map) {
+	const char *fileName = "./example_test.tmxb";
+	if (Tmx::BinaryMap::Write(*map, fileName) != 0) {
+		printf("binary map: could not be written\n");
+		return false;
+	}
+
+	bool passed = true;
+
+	// The tiles are copied out of the file, or used right from it.
+	Tmx::Map tilesMap;
+	tilesMap.ParseFile(fileName);
+	if (tilesMap.HasError() || !SameMaps(map, &tilesMap)) {
+		printf("binary map: the map read with TMX_STORAGE_TILES differs\n");
+		passed = false;
+	}
+
+	Tmx::Map gidsMap;
+	gidsMap.SetLayerStorage(Tmx::TMX_STORAGE_GIDS);
+	gidsMap.ParseFile(fileName);
+	if (gidsMap.HasError() || !SameMaps(map, &gidsMap)) {
+		printf("binary map: the map read with TMX_STORAGE_GIDS differs\n");
+		passed = false;
+	}
+
+	std::string data;
+	FILE *file = fopen(fileName, "rb");
+	if (file) {
+		char buffer[4096];
+		size_t count;
+		while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+			data.append(buffer, count);
+		}
+		fclose(file);
+	}
+	remove(fileName);
+
+	// Every truncated copy of the file is rejected.
+	for (size_t length = 0; length < data.size(); ++length) {
+		if (!IsRejected(data.substr(0, length))) {
+			printf("binary map: a file truncated to %d bytes is read\n", (int)length);
+			passed = false;
+			break;
+		}
+	}
+
+	// So are files whose counts, offsets or sizes point out of them. The
+	// header is made of 8 words, the string count, the content offset and
+	// the content size are words 3 to 5, the offsets of the strings follow.
+	const size_t damagedWords[] = { 3, 4, 5, 8 };
+	for (size_t i = 0; i < sizeof(damagedWords) / sizeof(damagedWords[0]); ++i) {
+		std::string damaged = data;
+		const unsigned badOffset = 0xFFFFFFF0;
+		damaged.replace(damagedWords[i] * 4, 4, (const char *)&badOffset, 4);
+		if (!IsRejected(damaged)) {
+			printf("binary map: a file with a bad word %d is read\n", (int)damagedWords[i]);
+			passed = false;
+		}
+	}
+
+	if (passed) {
+		printf("binary map: the map is read back the same, damaged files are rejected\n");
+	}
+	return passed;
+}
+
+// A map whose tiles have the properties the tile classifier is tested on.
+static const char *ClassifierMap =
+	"<map version=\"1.0\" orientation=\"orthogonal\" width=\"1\" height=\"1\" tilewidth=\"8\" tileheight=\"8\">"
+	" <tileset firstgid=\"1\" name=\"props\" tilewidth=\"8\" tileheight=\"8\" tilecount=\"8\">"
+	"  <tile id=\"0\"><properties><property name=\"wall\" value=\"\"/></properties></tile>"
+	"  <tile id=\"1\"><properties><property name=\"solid\" value=\"true\"/><property name=\"breakable\" value=\"true\"/></properties></tile>"
+	"  <tile id=\"2\"><properties><property name=\"solid\" value=\"true\"/></properties></tile>"
+	"  <tile id=\"3\"><properties><property name=\"material\" value=\"stone\"/></properties></tile>"
+	"  <tile id=\"4\"><properties><property name=\"damage\" value=\"12\"/></properties></tile>"
+	"  <tile id=\"5\"><properties><property name=\"kind\" value=\"lava\"/><property name=\"cooled\" value=\"\"/></properties></tile>"
+	" </tileset>"
+	" <tileset firstgid=\"10\" name=\"more\" tilewidth=\"8\" tileheight=\"8\" tilecount=\"2\">"
+	"  <tile id=\"0\"><properties><property name=\"material\" value=\"metal\"/></properties></tile>"
+	"  <tile id=\"1\"><properties><property name=\"damage\" value=\"9\"/><property name=\"kind\" value=\"lava\"/></properties></tile>"
+	" </tileset>"
+	"</map>";
+
+// Classify the tiles of a map by their properties and check that invalid
+// expressions are reported.
+static bool TestTileClassifier() {
+	Tmx::Map map;
+	map.ParseText(ClassifierMap);
+	if (map.HasError()) {
+		printf("tile classifier: error text: %s\n", map.GetErrorText().c_str());
+		return false;
+	}
+
+	Tmx::TileClassifier classifier;
+	classifier.AddClass("wall", "wall");
+	classifier.AddClass("solid", "solid && !breakable");
+	classifier.AddClass("material", "material in (stone, \"metal\")");
+	classifier.AddClass("hazard", "damage >= 10 || (kind == \"lava\" && !cooled)");
+	classifier.AddClass("empty", "!wall && !solid && !material && !damage && !kind");
+	if (classifier.HasError() || classifier.GetNumClasses() != 5) {
+		printf("tile classifier: error text: %s\n", classifier.GetErrorText().c_str());
+		return false;
+	}
+	classifier.Compile(&map);
+
+	// The class of every gid, the tiles without properties are empty and
+	// the gids out of the tilesets have no class.
+	const unsigned gids[] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 1 | 0x80000000, 4 | 0x20000000 };
+	const int classes[] = { 0, 1, 0, 2, 3, 4, 0, 5, 5, 0, 3, 4, 0, 1, 3 };
+	bool passed = true;
+	for (size_t i = 0; i < sizeof(gids) / sizeof(gids[0]); ++i) {
+		if (classifier.GetClass(gids[i]) != classes[i]) {
+			printf("tile classifier: gid %u is in class %d instead of %d\n", gids[i], classifier.GetClass(gids[i]), classes[i]);
+			passed = false;
+		}
+	}
+	if (classifier.Classify(map.GetTileset(0)->GetTile(4)->GetProperties()) != 4) {
+		printf("tile classifier: the properties of tile 4 are not in class 4\n");
+		passed = false;
+	}
+
+	// Expressions which do not compile add no class and tell why.
+	const char *invalidExpressions[] = {
+		"", "solid &&", "(wall", "wall)", "!", "damage >=", "material in (stone", "material in ()",
+		"kind == \"lava", "wall $", "wall solid"
+	};
+	for (size_t i = 0; i < sizeof(invalidExpressions) / sizeof(invalidExpressions[0]); ++i) {
+		Tmx::TileClassifier invalid;
+		if (invalid.AddClass("invalid", invalidExpressions[i]) != 0 || !invalid.HasError()
+			|| invalid.GetErrorText().empty() || invalid.GetNumClasses() != 0) {
+			printf("tile classifier: '%s' is compiled\n", invalidExpressions[i]);
+			passed = false;
+		}
+	}
+
+	if (passed) {
+		printf("tile classifier: the tiles are in their classes, invalid expressions are rejected\n");
+	}
+	return passed;
+}
+
+// Parse a map of 2 by 2 tiles whose layer has CSV data.
+static void ParseCSVMap(Tmx::Map &map, const std::string &csv) {
+	map.ParseText(
+		"<map version=\"1.0\" orientation=\"orthogonal\" width=\"2\" height=\"2\" tilewidth=\"8\" tileheight=\"8\">"
+		" <layer name=\"csv\" width=\"2\" height=\"2\"><data encoding=\"csv\">" + csv + "</data></layer>"
+		"</map>");
+}
+
+// Check that the CSV data of layers is read with any white space, empty
+// fields and a trailing comma, and that invalid data is reported.
+static bool TestCSV() {
+	bool passed = true;
+
+	const char *validData[] = {
+		"1,2,3,4", "1,2,3,4,", "\n1, 2,\n3 ,4\n", "1,2,\n3,4,\n", "1,,2,3,4", "1, ,2,3,4", ",1,2,3,4"
+	};
+	for (size_t i = 0; i < sizeof(validData) / sizeof(validData[0]); ++i) {
+		Tmx::Map map;
+		ParseCSVMap(map, validData[i]);
+		if (map.HasError() || map.GetLayer(0)->GetTileGid(0, 0) != 1 || map.GetLayer(0)->GetTileGid(1, 0) != 2
+			|| map.GetLayer(0)->GetTileGid(0, 1) != 3 || map.GetLayer(0)->GetTileGid(1, 1) != 4) {
+			printf("csv: '%s' is not read\n", validData[i]);
+			passed = false;
+		}
+	}
+
+	// Missing, extra, non numeric and too large values.
+	const char *invalidData[] = {
+		"1,2,3", "1,2,3,4,5", "1,2,x,4", "1 2,3,4", "1,2,3,-4", "1,2,3,4294967296"
+	};
+	for (size_t i = 0; i < sizeof(invalidData) / sizeof(invalidData[0]); ++i) {
+		Tmx::Map map;
+		ParseCSVMap(map, invalidData[i]);
+		if (map.GetErrorCode() != Tmx::TMX_INVALID_LAYER_DATA) {
+			printf("csv: '%s' is read\n", invalidData[i]);
+			passed = false;
+		}
+	}
+
+	if (passed) {
+		printf("csv: the layers are read, invalid data is rejected\n");
+	}
+	return passed;
+}
 
 int main() {
 	Tmx::Map *map = new Tmx::Map();
@@ -154,9 +475,40 @@ int main() {
 		}
 	}
 
+	// Parse the same map with its layers compressed with zstd instead of
+	// zlib, its tiles have to be the same.
+	Tmx::Map *zstdMap = new Tmx::Map();
+	zstdMap->ParseFile("./example/example_zstd.tmx");
+
+	bool zstdMatches = !zstdMap->HasError() && zstdMap->GetNumLayers() == map->GetNumLayers();
+	for (int i = 0; zstdMatches && i < map->GetNumLayers(); ++i) {
+		const Tmx::Layer *layer = map->GetLayer(i);
+		const Tmx::Layer *zstdLayer = zstdMap->GetLayer(i);
+
+		zstdMatches = zstdLayer->GetWidth() == layer->GetWidth() && zstdLayer->GetHeight() == layer->GetHeight();
+		for (int y = 0; zstdMatches && y < layer->GetHeight(); ++y) {
+			for (int x = 0; zstdMatches && x < layer->GetWidth(); ++x) {
+				zstdMatches = zstdLayer->GetTileGid(x, y) == layer->GetTileGid(x, y);
+			}
+		}
+	}
+
+	printf("\n");
+	if (zstdMatches) {
+		printf("zstd layers: the tiles match\n");
+	} else {
+		printf("zstd layers: the tiles differ\n");
+		printf("error text: %s\n", zstdMap->GetErrorText().c_str());
+	}
+
+	const bool binaryPassed = TestBinaryMap(map);
+	const bool classifierPassed = TestTileClassifier();
+	const bool csvPassed = TestCSV();
+
+	delete zstdMap;
 	delete map;
 
 	system("PAUSE");
 
-	return 0;
+	return zstdMatches && binaryPassed && classifierPassed && csvPassed ? 0 : 1;
 }
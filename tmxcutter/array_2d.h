@@ -266,10 +266,12 @@ namespace dyb
     template<class T>
     array2d<T> & array2d<T>::operator = (array2d<T> && other_image)
     {
+        delete[] data;
         data = other_image.data;
         other_image.data = nullptr;
         width = other_image.width;
         height = other_image.height;
+        return *this;
     }
 
     template<class T>
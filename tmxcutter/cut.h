@@ -15,7 +15,7 @@ namespace dyb
     typedef dyb::point2d<int> ivec2;
     typedef dyb::array2d<char> rect;
 
-    void print(rect & input)
+    inline void print(const rect & input)
     {
         for (int y = 0; y < input.get_height(); y++)
         {
@@ -25,7 +25,7 @@ namespace dyb
         }
     }
 
-    void fill_area(rect & r, int leftLowerX, int leftLowerY, int width, int height, char to_fill)
+    inline void fill_area(rect & r, int leftLowerX, int leftLowerY, int width, int height, char to_fill)
     {
         DEBUGCHECK(width > 0 && height > 0, "invalid width or height");
         DEBUGCHECK(r.is_valid_position(leftLowerX, leftLowerY),
@@ -51,42 +51,52 @@ namespace dyb
         ivec2 leftTop, rightBottom;
     };
 
+    // cell values of a class grid, 0 means the cell belongs to no class
+    typedef dyb::array2d<unsigned char> class_grid;
+
     using std::vector;
-    vector<TileRect> cut(rect & input)
+
+    // Cut the tile polygons of every class into rectangular pieces in a
+    // single traversal. A cell with value c (1 <= c <= classCount) belongs
+    // to class c, the rectangles of class c are stored in result[c - 1].
+    // Cells are visited column by column and every rectangle is grown down
+    // then right as far as cells of the same class allow.
+    // When preview is given, every rectangle is drawn in it with its own letter.
+    inline vector<vector<TileRect>> cut(const class_grid & input, int classCount, rect * preview = nullptr)
     {
         const int w = input.get_width(), h = input.get_height();
-        rect r(input); // result
+        class_grid left(input); // cells not yet covered by a rectangle
+        if (preview && w > 0 && h > 0)
+            fill_area(*preview, 0, 0, w, h, '.');
 
-        vector<TileRect> tileRects;
+        vector<vector<TileRect>> tileRects(classCount);
         char f = 'A';
-        while (1)
+        for (int x = 0; x < w; x++)
+        for (int y = 0; y < h; y++)
         {
-            auto it = find(input.begin(), input.end(), '0');
-            if (it == input.end()) break; // empty
-            const ivec2 p = input.iterToPoint(it);
+            const unsigned char c = left[x][y];
+            if (c == 0) continue;
+            DEBUGCHECK(c <= classCount, "invalid class");
 
-            int i = p.x, j = p.y;
-            while (j + 1 < h && input[i][j + 1] != '.')
+            int i = x, j = y;
+            while (j + 1 < h && left[i][j + 1] == c)
                 j++;
-            auto all_not_ampty = [&input](const int py, const int i, const int j){
+            auto all_same_class = [&left, c](const int py, const int i, const int j){
                 for (int k = py; k <= j; k++)
-                if (input[i][k] == '.') return false;
+                if (left[i][k] != c) return false;
                 return true;
             };
-            while (i + 1 < w && all_not_ampty(p.y, i + 1, j))
+            while (i + 1 < w && all_same_class(y, i + 1, j))
                 i++;
 
-            fill_area(r, p.x, p.y, i - p.x + 1, j - p.y + 1, f);
-            f++;
-            fill_area(input, p.x, p.y, i - p.x + 1, j - p.y + 1, '.');
+            if (preview)
+                fill_area(*preview, x, y, i - x + 1, j - y + 1, f++);
+            for (int k = x; k <= i; k++)
+            for (int l = y; l <= j; l++)
+                left[k][l] = 0;
 
-            tileRects.push_back({ p, ivec2(i, j) });
-            // print rectangle for debugging
-            /*echoivec2(p);
-            cout << i << ' ' << j << endl;
-            cout << "-----------------------" << endl;*/
+            tileRects[c - 1].push_back({ ivec2(x, y), ivec2(i, j) });
         }
-        print(r);  // print map with tiles grouped
         return tileRects;
     }
 
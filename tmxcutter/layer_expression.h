@@ -0,0 +1,315 @@
+#ifndef DYB_LAYER_EXPRESSION
+#define DYB_LAYER_EXPRESSION
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <ctype.h>
+#include "../TmxParser/Tmx.h"
+#include "cut.h"
+
+namespace dyb
+{
+    using std::string;
+    using std::vector;
+
+    // Match a layer name against a glob pattern, '*' matches any run of
+    // characters and '?' a single one.
+    inline bool glob_match(const char * pattern, const char * text)
+    {
+        const char * star = nullptr, * resume = nullptr;
+        while (*text)
+        {
+            if (*pattern == '*')
+            {
+                star = pattern++;
+                resume = text;
+            }
+            else if (*pattern == '?' || *pattern == *text)
+            {
+                ++pattern;
+                ++text;
+            }
+            else if (star)
+            {
+                pattern = star + 1;
+                text = ++resume;
+            }
+            else
+                return false;
+        }
+        while (*pattern == '*') ++pattern;
+        return *pattern == 0;
+    }
+
+    // Combination of several tile layers, such as
+    //   meta
+    //   meta, cliffs, props      (same as meta | cliffs | props)
+    //   collision_* & !bridges
+    // A cell is in a class when the combination of the layers is: '|' or ','
+    // keeps the classes found in either operand, '&' the classes found in
+    // both and '!' the classes not found. A name is a glob standing for
+    // every layer it matches, names with operator characters can be quoted.
+    // The expression is evaluated per cell while classifying, so the layers
+    // are combined without building a grid per layer.
+    class layer_expression
+    {
+    public:
+        // compile the expression against the layers of a map
+        bool parse(const string & text, const vector<Tmx::Layer *> & layers, string & error)
+        {
+            program.clear();
+            source = &text;
+            pos = 0;
+            mapLayers = &layers;
+            if (!next(error) || !parse_or(error)) return false;
+            if (token != token_end)
+            {
+                error = "unexpected '" + word + "' in layer expression";
+                return false;
+            }
+
+            const Tmx::Layer * first = program.front().layers.front();
+            for (auto & op : program)
+            {
+                for (const Tmx::Layer * layer : op.layers)
+                {
+                    if (layer->GetWidth() != first->GetWidth() || layer->GetHeight() != first->GetHeight())
+                    {
+                        error = "layers " + first->GetName() + " and " + layer->GetName() + " differ in size";
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        int width() const { return program.front().layers.front()->GetWidth(); }
+        int height() const { return program.front().layers.front()->GetHeight(); }
+
+        // a single layer keeps its class, combinations work on class masks
+        bool is_single_layer() const
+        {
+            return program.size() == 1 && program.front().layers.size() == 1;
+        }
+
+        // the most classes a combination of layers can tell apart
+        static int max_classes() { return 32; }
+
+        // classify every cell of the combined layers, a row at a time
+        void classify(const Tmx::TileClassifier & classifier, class_grid & output) const
+        {
+            // the gids of the current row of every layer loaded by the program
+            vector<const Tmx::Layer *> loaded;
+            for (auto & op : program)
+                loaded.insert(loaded.end(), op.layers.begin(), op.layers.end());
+            vector<unsigned int> buffer(static_cast<size_t>(width()) * loaded.size());
+            vector<const unsigned int *> rows(loaded.size());
+
+            const uint32_t all = classifier.GetNumClasses() >= 32 ? 0xffffffffu : (1u << classifier.GetNumClasses()) - 1;
+            vector<uint32_t> stack;
+            stack.reserve(program.size());
+            for (int y = 0; y < height(); ++y)
+            {
+                for (size_t l = 0; l < loaded.size(); ++l)
+                    rows[l] = row_gids(loaded[l], y, buffer.data() + l * width());
+
+                if (is_single_layer())
+                {
+                    const unsigned int * row = rows.front();
+                    for (int x = 0; x < width(); ++x)
+                        output[x][y] = classifier.GetClass(row[x]);
+                    continue;
+                }
+
+                for (int x = 0; x < width(); ++x)
+                {
+                    stack.clear();
+                    size_t l = 0;
+                    for (auto & op : program)
+                    {
+                        uint32_t mask = 0;
+                        switch (op.kind)
+                        {
+                        case op_load:
+                            for (size_t i = 0; i < op.layers.size(); ++i, ++l)
+                            {
+                                const unsigned char c = classifier.GetClass(rows[l][x]);
+                                if (c) mask |= 1u << (c - 1);
+                            }
+                            stack.push_back(mask);
+                            break;
+                        case op_not:
+                            stack.back() = ~stack.back() & all;
+                            break;
+                        case op_or:
+                            mask = stack.back();
+                            stack.pop_back();
+                            stack.back() |= mask;
+                            break;
+                        case op_and:
+                            mask = stack.back();
+                            stack.pop_back();
+                            stack.back() &= mask;
+                            break;
+                        }
+                    }
+
+                    // the first class found wins, as for a single layer
+                    unsigned char c = 0;
+                    if (uint32_t mask = stack.back())
+                        for (c = 1; !(mask & 1); mask >>= 1) ++c;
+                    output[x][y] = c;
+                }
+            }
+        }
+
+    private:
+        enum op_kind { op_load, op_or, op_and, op_not };
+        enum token_kind { token_end, token_name, token_or, token_and, token_not, token_open, token_close };
+
+        struct op
+        {
+            op_kind kind;
+            vector<const Tmx::Layer *> layers;
+        };
+
+        // the gids of a row, in place when the layer keeps its gids
+        // and copied to the buffer otherwise
+        static const unsigned int * row_gids(const Tmx::Layer * layer, int y, unsigned int * buffer)
+        {
+            if (const unsigned int * row = layer->GetRowGids(y))
+                return row;
+            layer->CopyGids(0, y, layer->GetWidth(), 1, buffer);
+            return buffer;
+        }
+
+        static bool is_operator(char c)
+        {
+            return c == '|' || c == ',' || c == '&' || c == '!' || c == '(' || c == ')' || c == '"';
+        }
+
+        bool next(string & error)
+        {
+            const string & text = *source;
+            while (pos < text.size() && isspace(static_cast<unsigned char>(text[pos]))) ++pos;
+            word.clear();
+            if (pos >= text.size())
+            {
+                token = token_end;
+                return true;
+            }
+
+            const char c = text[pos];
+            if (c == '"')
+            {
+                const size_t end = text.find('"', pos + 1);
+                if (end == string::npos)
+                {
+                    error = "unterminated quote in layer expression";
+                    return false;
+                }
+                word = text.substr(pos + 1, end - pos - 1);
+                token = token_name;
+                pos = end + 1;
+                return true;
+            }
+            if (!is_operator(c))
+            {
+                // names may contain spaces, only the surrounding ones are dropped
+                size_t end = pos;
+                while (end < text.size() && !is_operator(text[end])) ++end;
+                word = text.substr(pos, end - pos);
+                word.erase(word.find_last_not_of(" \t") + 1);
+                token = token_name;
+                pos = end;
+                return true;
+            }
+
+            word = string(1, c);
+            ++pos;
+            switch (c)
+            {
+            case '|': case ',': token = token_or; break;
+            case '&': token = token_and; break;
+            case '!': token = token_not; break;
+            case '(': token = token_open; break;
+            default: token = token_close; break;
+            }
+            return true;
+        }
+
+        bool parse_or(string & error)
+        {
+            if (!parse_and(error)) return false;
+            while (token == token_or)
+            {
+                if (!next(error) || !parse_and(error)) return false;
+                program.push_back({ op_or, {} });
+            }
+            return true;
+        }
+
+        bool parse_and(string & error)
+        {
+            if (!parse_unary(error)) return false;
+            while (token == token_and)
+            {
+                if (!next(error) || !parse_unary(error)) return false;
+                program.push_back({ op_and, {} });
+            }
+            return true;
+        }
+
+        bool parse_unary(string & error)
+        {
+            if (token == token_not)
+            {
+                if (!next(error) || !parse_unary(error)) return false;
+                program.push_back({ op_not, {} });
+                return true;
+            }
+            if (token == token_open)
+            {
+                if (!next(error) || !parse_or(error)) return false;
+                if (token != token_close)
+                {
+                    error = "expected ')' in layer expression";
+                    return false;
+                }
+                return next(error);
+            }
+            if (token != token_name)
+            {
+                error = "expected a layer name in layer expression";
+                return false;
+            }
+
+            op load = { op_load, {} };
+            for (const Tmx::Layer * layer : *mapLayers)
+            {
+                if (glob_match(word.c_str(), layer->GetName().c_str()))
+                    load.layers.push_back(layer);
+            }
+            if (load.layers.empty())
+            {
+                error = "can't find layer named " + word;
+                return false;
+            }
+            program.push_back(load);
+            return next(error);
+        }
+
+        vector<op> program;
+
+        // parser state
+        const string * source;
+        size_t pos;
+        token_kind token;
+        string word;
+        const vector<Tmx::Layer *> * mapLayers;
+    };
+
+}
+
+#endif
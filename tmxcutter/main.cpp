@@ -11,6 +11,7 @@
 #include "array_2d.h"
 #include "point2d.h"
 #include "cut.h"
+#include "tmxcutter.h"
 #include <fstream>
 
 using std::shared_ptr;
@@ -25,33 +26,135 @@ typedef dyb::array2d<char> rect;
 void printHelp()
 {
     cout << "usage :" << endl;
-    cout << "\t tmxcutter [tmx file] [layer name] [wall property name] [xml file name]" << endl<<endl;
-    cout << "\t [layer name] specify the layer where your 'wall tile' locate in" << endl;
-    cout << "\t Tiles with property [wall property name] will be seen as the 'wall tile' and will be grouped into rectangle" << endl;
+    cout << "\t tmxcutter [tmx file] [layers] [class list] [xml file name] [object group name]" << endl<<endl;
+    cout << "\t [layers] specify the layer where your 'wall tile' locate in, or a combination of layers" << endl;
+    cout << "\t such as meta,cliffs or collision_* & !bridges where names may use * and ? as wildcards" << endl;
+    cout << "\t and , or | keep the tiles of either layer, & the tiles of both and ! the tiles missing" << endl;
+    cout << "\t [class list] is a comma separated list of classes such as wall,water,oneway=true" << endl;
+    cout << "\t every class is [predicate] or [name]:[predicate], the predicate is a bare property name" << endl;
+    cout << "\t or an expression such as solid && !breakable, damage >= 10 or material in (stone, metal)" << endl;
+    cout << "\t Tiles whose properties match the predicate are seen as 'wall tile' of this class" << endl;
+    cout << "\t and the tiles of every class are grouped into rectangle" << endl;
     cout << "\t [xml file name] specify the output xml file you want to save" << endl;
+    cout << "\t [object group name] is optional, rectangle objects of this object group whose type is the name" << endl;
+    cout << "\t of a class or whose properties match its predicate are merged with the 'wall tile' of this class" << endl;
 }
 
-// The first argument is tmx file, the second one is layer name
+// Split the class list on the commas which are outside of parentheses
+// and quotes, and add every class to the classifier.
+bool parseClasses(const string & list, Tmx::TileClassifier & classifier)
+{
+    vector<string> specs(1);
+    int depth = 0;
+    char quote = 0;
+    for (char c : list)
+    {
+        if (quote)
+            quote = c == quote ? 0 : quote;
+        else if (c == '"' || c == '\'')
+            quote = c;
+        else if (c == '(')
+            ++depth;
+        else if (c == ')')
+            --depth;
+        else if (c == ',' && depth == 0)
+        {
+            specs.push_back(string());
+            continue;
+        }
+        specs.back() += c;
+    }
+
+    for (const string & spec : specs)
+    {
+        if (spec.find_first_not_of(" \t") == string::npos) continue;
+        // a class is named after its predicate unless it is given a name
+        string name = spec, expression = spec;
+        const size_t colon = spec.find(':');
+        if (colon != string::npos)
+        {
+            name = spec.substr(0, colon);
+            expression = spec.substr(colon + 1);
+        }
+        if (classifier.AddClass(name, expression) == 0) return false;
+    }
+    return classifier.GetNumClasses() > 0;
+}
+
+void writeRects(TiXmlElement * parent, const vector<dyb::PixelRect> & pixelrects)
+{
+    for (auto & pixelRect : pixelrects)
+    {
+        using std::to_string;
+        TiXmlElement * rect = new TiXmlElement("rect");
+        parent->LinkEndChild(rect);
+        TiXmlElement * width = new TiXmlElement("width");
+        TiXmlElement * height = new TiXmlElement("height");
+        rect->LinkEndChild(width);
+        rect->LinkEndChild(height);
+
+        ivec2 delta = pixelRect.rightBottom - pixelRect.leftTop;
+        width->LinkEndChild(new TiXmlText(to_string(delta.x + 1)));
+        height->LinkEndChild(new TiXmlText(to_string(delta.y + 1)));
+
+        TiXmlElement * leftTopX = new TiXmlElement("leftTopX");
+        TiXmlElement * leftTopY = new TiXmlElement("leftTopY");
+        TiXmlElement * rightBottomX = new TiXmlElement("rightBottomX");
+        TiXmlElement * rightBottomY = new TiXmlElement("rightBottomY");
+        rect->LinkEndChild(leftTopX);
+        rect->LinkEndChild(leftTopY);
+        rect->LinkEndChild(rightBottomX);
+        rect->LinkEndChild(rightBottomY);
+        leftTopX->LinkEndChild(new TiXmlText(to_string(pixelRect.leftTop.x)));
+        leftTopY->LinkEndChild(new TiXmlText(to_string(pixelRect.leftTop.y)));
+        rightBottomX->LinkEndChild(new TiXmlText(to_string(pixelRect.rightBottom.x)));
+        rightBottomY->LinkEndChild(new TiXmlText(to_string(pixelRect.rightBottom.y)));
+    }
+}
+
+// The first argument is tmx file, the second one is layer expression
 int main(int args, char * argv[])
 {
-    if (args != 5) 
+    if (args != 5 && args != 6)
     {
         printHelp();
         return 0;
     }
     const string tmxFile = argv[1];
-    const string layerName = argv[2];
-    const string wallPropertyName = argv[3];
+    const string layerList = argv[2];
+    const string classList = argv[3];
     const string savedXmlFile = argv[4];
+    const string objectGroupName = args == 6 ? argv[5] : "";
 
     // for debugging
     /*const string tmxFile = "forest.tmx";
-    const string layerName = "meta";
-    const string wallPropertyName = "wall";
+    const string layerList = "meta";
+    const string classList = "wall";
     const string savedXmlFile = "output.xml";*/
 
+    Tmx::TileClassifier classifier;
+    if (!parseClasses(classList, classifier))
+    {
+        cout << "invalid class list : " << classList << endl;
+        if (classifier.HasError())
+            cout << "error text: " << classifier.GetErrorText() << endl;
+        return 1;
+    }
+    const int classCount = classifier.GetNumClasses();
+
+    // only the gids of the layers which are cut are needed
     shared_ptr<Tmx::Map> map(new Tmx::Map());
-    map->ParseFile(tmxFile);
+    map->SetLayerStorage(Tmx::TMX_STORAGE_GIDS);
+    map->SetLazyDecoding(true);
+
+    // image layers and other object groups are never built
+    Tmx::ParseOptions options;
+    options.Skip(Tmx::TMX_PARSE_IMAGE_LAYERS);
+    if (objectGroupName.empty())
+        options.Skip(Tmx::TMX_PARSE_OBJECT_GROUPS);
+    else
+        options.Include(Tmx::TMX_PARSE_OBJECT_GROUPS, objectGroupName);
+    map->ParseFile(tmxFile, options);
     if (map->HasError())
     {
         cout << "error code : " << map->GetErrorCode() << endl;
@@ -59,73 +162,41 @@ int main(int args, char * argv[])
         return map->GetErrorCode();
     }
 
-    // find wall tile ids
-    vector<Tmx::Tile*> wallTiles;
-    vector<unsigned int> wallTileIDs;
-    for (Tmx::Tileset * tileset : map->GetTilesets())
-    {
-        for (Tmx::Tile * tile : tileset->GetTiles())
-        {
-            if (tile->GetProperties().HasProperty(wallPropertyName))
-                wallTiles.push_back(tile);
-        }
-    }
-    for (auto tile : wallTiles)
-        wallTileIDs.push_back(tile->GetId());
-    if (wallTiles.empty())
-    {
-        cout << "can't find tile with property :" << wallPropertyName << endl;
-        return 1;
-    }
-
-    // find layer
-    auto layers = map->GetLayers();
-    auto layerIter = std::find_if(begin(layers), end(layers), [&layerName](Tmx::Layer * layer){
-        return layer->GetName() == layerName;
-    });
-    if (layerIter == end(layers))
+    // classify every gid once, a tile belongs to the first class it matches
+    // and gids of tiles matching no class stay in class 0
+    classifier.Compile(map.get());
+    const vector<unsigned char> & gidClasses = classifier.GetTable();
+    if (std::count(gidClasses.begin(), gidClasses.end(), 0) == static_cast<std::ptrdiff_t>(gidClasses.size()))
     {
-        cout << "can't find layer named " << layerName << endl;
+        cout << "can't find tile with property :" << classList << endl;
         return 1;
     }
-    Tmx::Layer * layer = *layerIter;
 
-    // construct map
-    rect input(layer->GetWidth(), layer->GetHeight());
-    for (int y = 0; y < layer->GetHeight(); ++y)
+    const Tmx::ObjectGroup * objectGroup = nullptr;
+    if (!objectGroupName.empty())
     {
-        for (int x = 0; x < layer->GetWidth(); ++x)
+        objectGroup = map->FindObjectGroup(objectGroupName);
+        if (!objectGroup)
         {
-            unsigned int id = layer->GetTileId(x, y);
-            // '0' means the tile is wall and sprite can't intersect with it while '.' means not
-            // this two tag will be used in cut() function to cut the tile polygons to rectangular pieces
-            if (find(begin(wallTileIDs), end(wallTileIDs), id) != end(wallTileIDs))
-                input[x][y] = '0';
-            else input[x][y] = '.';
+            cout << "can't find object group named " << objectGroupName << endl;
+            return 1;
         }
     }
 
-    // cut tile polygons into rectangular pieces
-    using dyb::TileRect;
+    // cut tile polygons of every class into rectangular pieces
     using dyb::PixelRect;
-    vector<TileRect> tileRects = dyb::cut(input);
-
-    vector<PixelRect> pixelrects;
-    for (auto & tileRect : tileRects)
+    string error;
+    rect preview(0, 0);
+    vector<vector<PixelRect>> pixelrects = dyb::cut_layers(*map, layerList, classifier, objectGroup, error, &preview);
+    if (!error.empty())
     {
-        ivec2 leftTop, rightBottom;
-        leftTop.x = tileRect.leftTop.x * map->GetTileWidth();
-        leftTop.y = tileRect.leftTop.y * map->GetTileHeight();
-        rightBottom.x = (tileRect.rightBottom.x + 1) * map->GetTileWidth() - 1;
-        rightBottom.y = (tileRect.rightBottom.y + 1) * map->GetTileHeight() - 1;
-        pixelrects.push_back({leftTop, rightBottom});
-        // for debugging
-        /*dyb::echoivec2(leftTop);
-        dyb::echoivec2(rightBottom);
-        cout << "--------------------------" << endl;*/
+        cout << error << endl;
+        return 1;
     }
+    dyb::print(preview);  // print map with tiles grouped
 
-    // write result to xml file
+    // write result to xml file, with several classes the rectangles
+    // are grouped in one element per class
     TiXmlDocument doc;
     TiXmlDeclaration * decl = new TiXmlDeclaration("1.0", "", "");
     doc.LinkEndChild(decl);
@@ -135,32 +206,17 @@ int main(int args, char * argv[])
     root->SetAttribute("mapHeight", map->GetHeight());
     root->SetAttribute("tileWidth", map->GetTileWidth());
     root->SetAttribute("tileHeight", map->GetTileWidth());
-    for (auto & pixelRect : pixelrects)
+    if (classCount == 1)
+        writeRects(root, pixelrects[0]);
+    else
     {
-        using std::to_string;
-        TiXmlElement * rect = new TiXmlElement("rect");
-        root->LinkEndChild(rect);
-        TiXmlElement * width = new TiXmlElement("width");
-        TiXmlElement * height = new TiXmlElement("height");
-        rect->LinkEndChild(width);
-        rect->LinkEndChild(height);
-
-        ivec2 delta = pixelRect.rightBottom - pixelRect.leftTop;
-        width->LinkEndChild(new TiXmlText(to_string(delta.x + 1)));
-        height->LinkEndChild(new TiXmlText(to_string(delta.y + 1)));
-
-        TiXmlElement * leftTopX = new TiXmlElement("leftTopX");
-        TiXmlElement * leftTopY = new TiXmlElement("leftTopY");
-        TiXmlElement * rightBottomX = new TiXmlElement("rightBottomX");
-        TiXmlElement * rightBottomY = new TiXmlElement("rightBottomY");
-        rect->LinkEndChild(leftTopX);
-        rect->LinkEndChild(leftTopY);
-        rect->LinkEndChild(rightBottomX);
-        rect->LinkEndChild(rightBottomY);
-        leftTopX->LinkEndChild(new TiXmlText(to_string(pixelRect.leftTop.x)));
-        leftTopY->LinkEndChild(new TiXmlText(to_string(pixelRect.leftTop.y)));
-        rightBottomX->LinkEndChild(new TiXmlText(to_string(pixelRect.rightBottom.x)));
-        rightBottomY->LinkEndChild(new TiXmlText(to_string(pixelRect.rightBottom.y)));
+        for (int c = 0; c < classCount; ++c)
+        {
+            TiXmlElement * classElement = new TiXmlElement("class");
+            root->LinkEndChild(classElement);
+            classElement->SetAttribute("name", classifier.GetName(c + 1));
+            writeRects(classElement, pixelrects[c]);
+        }
     }
     doc.SaveFile(savedXmlFile);
 
@@ -52,12 +52,6 @@ namespace dyb
             return *this;
         }
 
-        point2d & operator = (const point2d & rhs)
-        {
-            x = rhs.x; y = rhs.y;
-            return *this;
-        }
-
         friend bool operator == (const point2d & lhs, const point2d & rhs)
         {
             return abs(lhs.x - rhs.x) < 0.000001
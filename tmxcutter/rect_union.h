@@ -0,0 +1,192 @@
+#ifndef DYB_RECT_UNION
+#define DYB_RECT_UNION
+
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <iterator>
+#include "point2d.h"
+#include "cut.h"
+
+namespace dyb
+{
+    using std::vector;
+
+    // Segment tree over the compressed y coordinates of a set of rectangles.
+    // Every node keeps how many rectangles cover it entirely and how much of
+    // its span is covered, which is enough to enumerate the covered runs.
+    class coverage_tree
+    {
+    public:
+        explicit coverage_tree(const vector<int> & _ys)
+            : ys(_ys), cover(4 * _ys.size(), 0), length(4 * _ys.size(), 0)
+        {
+        }
+
+        // add delta to the cover count of elementary segments [lo, hi)
+        void update(int lo, int hi, int delta)
+        {
+            if (lo < hi) update(1, 0, segments(), lo, hi, delta);
+        }
+
+        // append the covered runs inside elementary segments [lo, hi)
+        // as pairs of pixel coordinates, adjacent runs are merged
+        void collect(int lo, int hi, vector<std::pair<int, int>> & runs) const
+        {
+            if (lo < hi) collect(1, 0, segments(), lo, hi, runs);
+        }
+
+        int segments() const { return static_cast<int>(ys.size()) - 1; }
+
+    private:
+        void update(int node, int l, int r, int lo, int hi, int delta)
+        {
+            if (hi <= l || r <= lo) return;
+            if (lo <= l && r <= hi)
+                cover[node] += delta;
+            else
+            {
+                const int m = (l + r) / 2;
+                update(2 * node, l, m, lo, hi, delta);
+                update(2 * node + 1, m, r, lo, hi, delta);
+            }
+            if (cover[node] > 0)
+                length[node] = ys[r] - ys[l];
+            else if (r - l == 1)
+                length[node] = 0;
+            else
+                length[node] = length[2 * node] + length[2 * node + 1];
+        }
+
+        void collect(int node, int l, int r, int lo, int hi,
+            vector<std::pair<int, int>> & runs) const
+        {
+            if (hi <= l || r <= lo || length[node] == 0) return;
+            if (cover[node] > 0)
+            {
+                const int y0 = ys[std::max(l, lo)], y1 = ys[std::min(r, hi)];
+                if (!runs.empty() && runs.back().second == y0)
+                    runs.back().second = y1;
+                else
+                    runs.push_back(std::make_pair(y0, y1));
+                return;
+            }
+            const int m = (l + r) / 2;
+            collect(2 * node, l, m, lo, hi, runs);
+            collect(2 * node + 1, m, r, lo, hi, runs);
+        }
+
+        const vector<int> & ys;
+        vector<int> cover;
+        vector<int> length;
+    };
+
+    // Compute the union of arbitrary pixel rectangles and partition it into
+    // non-overlapping rectangles.
+    // A vertical line sweeps over the x coordinates where rectangles start or
+    // end; between two such coordinates the covered y runs are constant and
+    // a run which is unchanged keeps extending the rectangle it opened, so
+    // the result is made of maximal horizontal strips of equal runs.
+    // The cost depends on the number of rectangles, not on their area.
+    inline vector<PixelRect> unite(const vector<PixelRect> & rects)
+    {
+        struct event
+        {
+            int x, y0, y1, delta;
+            bool operator < (const event & other) const { return x < other.x; }
+        };
+
+        // PixelRect is inclusive, the sweep works on half open intervals
+        vector<event> events;
+        vector<int> ys;
+        for (const PixelRect & r : rects)
+        {
+            if (r.rightBottom.x < r.leftTop.x || r.rightBottom.y < r.leftTop.y)
+                continue;
+            const int y0 = r.leftTop.y, y1 = r.rightBottom.y + 1;
+            events.push_back({ r.leftTop.x, y0, y1, 1 });
+            events.push_back({ r.rightBottom.x + 1, y0, y1, -1 });
+            ys.push_back(y0);
+            ys.push_back(y1);
+        }
+        vector<PixelRect> result;
+        if (events.empty()) return result;
+
+        std::sort(events.begin(), events.end());
+        std::sort(ys.begin(), ys.end());
+        ys.erase(std::unique(ys.begin(), ys.end()), ys.end());
+        auto index = [&ys](int y){
+            return static_cast<int>(std::lower_bound(ys.begin(), ys.end(), y) - ys.begin());
+        };
+
+        // rectangles still growing along x, keyed by their top
+        struct open_rect { int bottom, left; };
+        struct closed_rect { int top, bottom, left; bool continued; };
+        std::map<int, open_rect> open;
+
+        coverage_tree tree(ys);
+        vector<std::pair<int, int>> ranges, runs;
+        vector<closed_rect> closed;
+        for (size_t i = 0; i < events.size();)
+        {
+            const int x = events[i].x;
+
+            // apply every event at this x and remember which y ranges changed
+            ranges.clear();
+            for (; i < events.size() && events[i].x == x; ++i)
+            {
+                tree.update(index(events[i].y0), index(events[i].y1), events[i].delta);
+                ranges.push_back(std::make_pair(events[i].y0, events[i].y1));
+            }
+            std::sort(ranges.begin(), ranges.end());
+
+            for (size_t k = 0; k < ranges.size();)
+            {
+                int lo = ranges[k].first, hi = ranges[k].second;
+                for (++k; k < ranges.size() && ranges[k].first <= hi; ++k)
+                    hi = std::max(hi, ranges[k].second);
+
+                // take out the open rectangles touching the changed range,
+                // the range grows to cover them so their runs are rebuilt
+                closed.clear();
+                auto it = open.upper_bound(hi);
+                while (it != open.begin())
+                {
+                    auto prev = std::prev(it);
+                    if (prev->second.bottom < lo) break;
+                    closed.push_back({ prev->first, prev->second.bottom, prev->second.left, false });
+                    lo = std::min(lo, prev->first);
+                    hi = std::max(hi, prev->second.bottom);
+                    it = open.erase(prev);
+                }
+
+                // a run which did not change keeps its rectangle growing
+                runs.clear();
+                tree.collect(index(lo), index(hi), runs);
+                std::reverse(closed.begin(), closed.end());
+                size_t c = 0;
+                for (auto & run : runs)
+                {
+                    open_rect o = { run.second, x };
+                    while (c < closed.size() && closed[c].top < run.first) ++c;
+                    if (c < closed.size() && closed[c].top == run.first && closed[c].bottom == run.second)
+                    {
+                        o.left = closed[c].left;
+                        closed[c].continued = true;
+                    }
+                    open[run.first] = o;
+                }
+                for (auto & r : closed)
+                {
+                    if (!r.continued && r.left < x)
+                        result.push_back({ ivec2(r.left, r.top), ivec2(x - 1, r.bottom - 1) });
+                }
+            }
+        }
+        // the coverage is empty after the last event, so is the open set
+        return result;
+    }
+
+}
+
+#endif
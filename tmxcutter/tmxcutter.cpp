@@ -0,0 +1,154 @@
+#include <algorithm>
+#include "tmxcutter.h"
+#include "rect_union.h"
+#include "layer_expression.h"
+
+namespace dyb
+{
+    namespace
+    {
+        // scale the tile rectangles of every class to pixels
+        vector<vector<PixelRect>> to_pixels(const vector<vector<TileRect>> & tileRects,
+            int tileWidth, int tileHeight)
+        {
+            vector<vector<PixelRect>> pixelrects(tileRects.size());
+            for (size_t c = 0; c < tileRects.size(); ++c)
+            {
+                for (auto & tileRect : tileRects[c])
+                {
+                    ivec2 leftTop, rightBottom;
+                    leftTop.x = tileRect.leftTop.x * tileWidth;
+                    leftTop.y = tileRect.leftTop.y * tileHeight;
+                    rightBottom.x = (tileRect.rightBottom.x + 1) * tileWidth - 1;
+                    rightBottom.y = (tileRect.rightBottom.y + 1) * tileHeight - 1;
+                    pixelrects[c].push_back({ leftTop, rightBottom });
+                }
+            }
+            return pixelrects;
+        }
+
+        // copy the rectangles to the buffer of the caller, grouped by class
+        void write_rects(const vector<vector<PixelRect>> & pixelrects,
+            PixelRect * rects, size_t capacity, size_t * classCounts, size_t * count)
+        {
+            size_t total = 0;
+            for (size_t c = 0; c < pixelrects.size(); ++c)
+            {
+                for (auto & pixelRect : pixelrects[c])
+                {
+                    if (total < capacity) rects[total] = pixelRect;
+                    ++total;
+                }
+                if (classCounts) classCounts[c] = pixelrects[c].size();
+            }
+            if (count) *count = total;
+        }
+    }
+
+    vector<vector<PixelRect>> cut_layers(const Tmx::Map & map, const string & layers,
+        const Tmx::TileClassifier & classifier, const Tmx::ObjectGroup * objectGroup,
+        string & error, rect * preview)
+    {
+        error.clear();
+        const int classCount = classifier.GetNumClasses();
+        if (classCount == 0)
+        {
+            error = "no class to cut";
+            return vector<vector<PixelRect>>();
+        }
+
+        layer_expression expression;
+        if (!expression.parse(layers, map.GetLayers(), error))
+            return vector<vector<PixelRect>>();
+        if (!expression.is_single_layer() && classCount > layer_expression::max_classes())
+        {
+            error = "at most " + std::to_string(layer_expression::max_classes())
+                + " classes can be used with several layers";
+            return vector<vector<PixelRect>>();
+        }
+
+        // the class of the tile, 0 means sprite can pass through it
+        // the classes are used in cut() to cut the tile polygons to rectangular pieces
+        class_grid input(expression.width(), expression.height());
+        expression.classify(classifier, input);
+
+        if (preview)
+            *preview = rect(expression.width(), expression.height());
+        vector<vector<PixelRect>> pixelrects = to_pixels(cut(input, classCount, preview),
+            map.GetTileWidth(), map.GetTileHeight());
+
+        // merge rectangle objects, they are not aligned to the tile grid
+        // so the union is computed in pixel space
+        if (objectGroup)
+        {
+            for (Tmx::Object * object : objectGroup->GetObjects())
+            {
+                if (object->GetEllipse() || object->GetPolygon() || object->GetPolyline())
+                    continue;
+                if (object->GetWidth() <= 0 || object->GetHeight() <= 0)
+                    continue;
+
+                // the first class whose name is the type or whose predicate matches
+                int classId = classifier.Classify(object->GetProperties());
+                for (int c = 1; c <= classCount && (classId == 0 || c < classId); ++c)
+                {
+                    if (object->GetType() == classifier.GetName(c))
+                    {
+                        classId = c;
+                        break;
+                    }
+                }
+                if (classId == 0)
+                    continue;
+                ivec2 leftTop(object->GetX(), object->GetY());
+                ivec2 rightBottom(object->GetX() + object->GetWidth() - 1, object->GetY() + object->GetHeight() - 1);
+                pixelrects[classId - 1].push_back({ leftTop, rightBottom });
+            }
+            for (auto & rects : pixelrects)
+                rects = unite(rects);
+        }
+        return pixelrects;
+    }
+
+    bool cut_map(const Tmx::Map & map, const string & layers,
+        const Tmx::TileClassifier & classifier, const Tmx::ObjectGroup * objectGroup,
+        PixelRect * rects, size_t capacity, size_t * classCounts, size_t * count,
+        string & error)
+    {
+        vector<vector<PixelRect>> pixelrects = cut_layers(map, layers, classifier, objectGroup, error);
+        if (!error.empty())
+            return false;
+        write_rects(pixelrects, rects, capacity, classCounts, count);
+        return true;
+    }
+
+    bool cut_gids(const unsigned int * gids, int width, int height, int tileWidth, int tileHeight,
+        const Tmx::TileClassifier & classifier,
+        PixelRect * rects, size_t capacity, size_t * classCounts, size_t * count,
+        string & error)
+    {
+        error.clear();
+        const int classCount = classifier.GetNumClasses();
+        if (classCount == 0)
+        {
+            error = "no class to cut";
+            return false;
+        }
+        if (width < 0 || height < 0)
+        {
+            error = "invalid size " + std::to_string(width) + "x" + std::to_string(height);
+            return false;
+        }
+
+        class_grid input(width, height);
+        for (int y = 0; y < height; ++y)
+        {
+            const unsigned int * row = gids + static_cast<size_t>(y) * width;
+            for (int x = 0; x < width; ++x)
+                input[x][y] = classifier.GetClass(row[x]);
+        }
+        write_rects(to_pixels(cut(input, classCount), tileWidth, tileHeight),
+            rects, capacity, classCounts, count);
+        return true;
+    }
+}
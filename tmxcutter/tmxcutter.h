@@ -0,0 +1,53 @@
+#ifndef DYB_TMXCUTTER
+#define DYB_TMXCUTTER
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include "../TmxParser/Tmx.h"
+#include "cut.h"
+
+// In-process interface of the cutter, built as libtmxcutter.
+// Tiles are sorted into classes by a Tmx::TileClassifier compiled against
+// the map, the tiles of every class are cut into rectangles and the
+// rectangles are returned in pixels.
+namespace dyb
+{
+    using std::string;
+    using std::vector;
+
+    // Cut the layers of a map selected by a layer expression (see
+    // layer_expression.h). Rectangle objects of objectGroup, when given,
+    // whose type is the name of a class or whose properties match it are
+    // merged with the tiles of this class.
+    // The rectangles of class c are stored in result[c - 1]. On error the
+    // result is empty and error tells why. When preview is given, it is
+    // resized to the layers and the tile rectangles are drawn in it.
+    vector<vector<PixelRect>> cut_layers(const Tmx::Map & map, const string & layers,
+        const Tmx::TileClassifier & classifier, const Tmx::ObjectGroup * objectGroup,
+        string & error, rect * preview = nullptr);
+
+    // Same as cut_layers, the rectangles are written to a buffer given by
+    // the caller, grouped by class, and classCounts (GetNumClasses() entries,
+    // may be null) receives how many rectangles each class has.
+    // count receives the total amount of rectangles, which may be greater
+    // than capacity: only the first capacity ones are written then, so the
+    // call can be repeated with a large enough buffer.
+    // Returns false on error.
+    bool cut_map(const Tmx::Map & map, const string & layers,
+        const Tmx::TileClassifier & classifier, const Tmx::ObjectGroup * objectGroup,
+        PixelRect * rects, size_t capacity, size_t * classCounts, size_t * count,
+        string & error);
+
+    // Cut a raw buffer of width * height gids stored row by row, as found
+    // in the layer data of a tmx file; flip flags are ignored.
+    // The output is the same as for cut_map.
+    // Returns false when the size or the classifier is invalid, error
+    // tells which.
+    bool cut_gids(const unsigned int * gids, int width, int height, int tileWidth, int tileHeight,
+        const Tmx::TileClassifier & classifier,
+        PixelRect * rects, size_t capacity, size_t * classCounts, size_t * count,
+        string & error);
+}
+
+#endif